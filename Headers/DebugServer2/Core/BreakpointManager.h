@@ -100,6 +100,9 @@ public:
   virtual void enable(Target::Thread *thread = nullptr);
   virtual void disable(Target::Thread *thread = nullptr);
 
+protected:
+  void removeTemporaryBreakpoints();
+
 protected:
   virtual ErrorCode enableLocation(Site const &site,
                                    Target::Thread *thread = nullptr) = 0;
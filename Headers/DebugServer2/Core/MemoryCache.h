@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Core/ErrorCodes.h"
+#include "DebugServer2/Types.h"
+
+#include <functional>
+#include <map>
+#include <set>
+
+namespace ds2 {
+
+//
+// Page-granular cache of inferior memory, valid while the inferior is
+// stopped. Pages are fetched in bulk on first access and kept until the
+// cache is cleared, which has to happen before any thread runs again.
+// Pages that couldn't be fetched are remembered for as long, so that probing
+// them again goes straight to the target. Writes made through the debugger
+// are applied to cached pages in place.
+//
+class MemoryCache {
+public:
+  typedef std::function<ErrorCode(uint64_t address, void *data, size_t length,
+                                  size_t *count)>
+      FetchCallback;
+
+private:
+  std::map<uint64_t, ByteVector> _pages;
+  std::set<uint64_t> _unreadable;
+  size_t _pageSize;
+  size_t _maxPages;
+
+public:
+  MemoryCache(size_t maxPages = 256);
+
+public:
+  ErrorCode read(Address const &address, void *data, size_t length,
+                 size_t *count, FetchCallback const &fetch);
+  void update(Address const &address, void const *data, size_t length);
+
+public:
+  void clear() {
+    _pages.clear();
+    _unreadable.clear();
+  }
+};
+} // namespace ds2
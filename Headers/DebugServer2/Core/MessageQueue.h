@@ -12,34 +12,84 @@
 
 #include "DebugServer2/Base.h"
 
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <condition_variable>
-#include <deque>
 #include <mutex>
-#include <string>
 
 namespace ds2 {
 
+//
+// Hands packets from the session thread (the only producer) to the main
+// thread (the only consumer) through a bounded ring. Slots keep their
+// buffers from one packet to the next and are swapped with the consumer's,
+// so that passing a packet along doesn't allocate once the queue is warm.
+//
 class MessageQueue {
 private:
-  std::deque<std::string> _messages;
-  std::condition_variable _ready;
-  std::mutex _lock;
-  bool _terminated;
+  static size_t const kCapacity = 64;
+
+  //
+  // Wakes up the other side when it went to sleep waiting on the ring; the
+  // side that has something to report only makes a system call if the
+  // other side said it was about to sleep.
+  //
+  class Event {
+  private:
+    std::atomic<bool> _waiting;
+    std::mutex _lock;
+    std::condition_variable _cond;
+    bool _signaled;
+
+  public:
+    Event();
+
+  public:
+    template <typename Predicate> bool wait(int ms, Predicate ready);
+    void signal();
+
+  private:
+    bool sleep(int ms);
+  };
+
+private:
+  std::string _slots[kCapacity];
+  alignas(64) std::atomic<uint64_t> _head;
+  alignas(64) std::atomic<uint64_t> _tail;
+  std::atomic<uint64_t> _discard;
+  // Position of the slot the consumer is swapping out plus one, zero when
+  // it isn't; discarding doesn't free that slot until the consumer is done.
+  std::atomic<uint64_t> _reading;
+  std::atomic<bool> _terminated;
+  Event _readable;
+  Event _writable;
 
 public:
   MessageQueue();
 
 public:
-  void put(std::string const &message);
-  std::string get(int wait = -1); // Wait is expressed in milliseconds
+  // Producer side. Blocks while the queue is full.
+  void put(std::string_view message);
+
+  // Consumer side. Swaps the next message into `message`, returns false if
+  // there was none after the timeout (expressed in milliseconds) or if the
+  // queue has been terminated.
+  bool get(std::string &message, int wait = -1);
 
   // Wait until the queue is non-empty.  Returns false if
   // the queue is empty after the timeout, true otherwise.
-  // (Note that get() may still block after returning if
-  // another thread pulls from the queue.)
   bool wait(int ms = -1);
 
 public:
+  // Without `terminating`, drops the messages queued so far and must only be
+  // called by the producer. Terminating wakes up both sides for good.
   void clear(bool terminating);
+
+private:
+  inline bool empty() const { return head() == _tail.load(); }
+  uint64_t head() const;
+  bool writable(uint64_t tail) const;
 };
 } // namespace ds2
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/GDBRemote/PacketProcessor.h"
+#include "DebugServer2/GDBRemote/Session.h"
+#include "DebugServer2/Host/Channel.h"
+
+#include <deque>
+#include <string>
+
+//
+// Runs a session from the event loop (see Host::Linux::EventLoop) rather
+// than from a thread of its own like SessionThread does. The client is read
+// whenever the main thread waits, including while a command waits on the
+// inferior: interrupts are acted on right away, other packets are held until
+// the command in progress is done.
+//
+class SessionLoop : public ds2::GDBRemote::PacketProcessorDelegate {
+private:
+  ds2::Host::Channel *_channel;
+  ds2::GDBRemote::Session *_session;
+  ds2::GDBRemote::PacketProcessor _pp;
+  std::deque<std::string> _pending;
+  std::string _receiveBuffer;
+  int _fd;
+
+public:
+  SessionLoop(ds2::Host::Channel *channel, ds2::GDBRemote::Session *session);
+  ~SessionLoop();
+
+public:
+  void run();
+
+protected:
+  void onPacketData(std::string_view data, bool valid) override;
+  void onInvalidData(std::string_view data) override;
+
+private:
+  void onReadable();
+};
@@ -33,8 +33,8 @@ public:
   void start();
 
 protected:
-  void onPacketData(std::string const &data, bool valid) override;
-  void onInvalidData(std::string const &data) override;
+  void onPacketData(std::string_view data, bool valid) override;
+  void onInvalidData(std::string_view data) override;
 
 private:
   void run();
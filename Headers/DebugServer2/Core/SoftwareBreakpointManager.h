@@ -17,6 +17,7 @@ class SoftwareBreakpointManager : public BreakpointManager {
 private:
   std::map<uint64_t, ByteVector> _insns;
   bool _enabled;
+  bool _persistent;
 
 public:
   SoftwareBreakpointManager(Target::ProcessBase *process);
@@ -41,6 +42,21 @@ public:
   void enable(Target::Thread *thread = nullptr) override;
   void disable(Target::Thread *thread = nullptr) override;
 
+public:
+  // In persistent mode, breakpoint opcodes are left in the inferior's memory
+  // across stops instead of being inserted and removed around every resume.
+  // The process is then responsible for hiding them from memory reads with
+  // maskMemory() and for reporting its memory writes with updateMemory().
+  void setPersistent(bool persistent) { _persistent = persistent; }
+  bool persistent() const { return _persistent; }
+
+  void maskMemory(Address const &address, void *data, size_t length) const;
+  void updateMemory(Address const &address, void const *data, size_t length);
+
+  // Forget about inserted opcodes without restoring anything, e.g. when the
+  // inferior's address space was replaced by execve(2).
+  void discardLocations() { _insns.clear(); }
+
 protected:
   ErrorCode isValid(Address const &address, size_t size,
                     Mode mode) const override;
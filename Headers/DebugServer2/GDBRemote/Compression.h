@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ds2 {
+namespace GDBRemote {
+
+//
+// Packet compression as negotiated by LLDB's QEnableCompression. Compressed
+// packets are framed as C<uncompressed-size>:<escaped compressed data>,
+// packets that were left alone as N<payload>.
+//
+enum CompressionType {
+  kCompressionTypeNone,
+  kCompressionTypeZlibDeflate,
+  kCompressionTypeLZ4,
+};
+
+// Packets with a payload at or below this size are not worth compressing.
+static size_t const kDefaultCompressionMinSize = 384;
+
+// Comma separated list for the SupportedCompressions qSupported feature,
+// empty if ds2 was built without any compression library.
+std::string SupportedCompressions();
+
+bool ParseCompressionType(std::string const &name, CompressionType &type);
+
+// Compresses `payload` and appends the framed result to `packet`, using the
+// uncompressed N framing if compression fails or doesn't pay off. Either way
+// at most one byte is added to the size of `payload`.
+void FrameCompressedPayload(CompressionType type, size_t minSize,
+                            std::string const &payload, std::string &packet);
+} // namespace GDBRemote
+} // namespace ds2
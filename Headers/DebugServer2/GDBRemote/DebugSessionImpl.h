@@ -45,6 +45,23 @@ protected:
   mutable IterationState<ThreadId> _threadIterationState;
 
 protected:
+  // The last qXfer document generated for each object, so that reading it
+  // in chunks doesn't regenerate it for every chunk. Documents are only
+  // valid for the image they were made from, and those describing the
+  // inferior's state only for the stop they were made in.
+  struct XferDocument {
+    std::string annex;
+    std::string data;
+    CompatibilityMode mode;
+    bool stopScoped;
+    uint64_t execGeneration;
+    uint64_t stopGeneration;
+  };
+  std::map<std::string, XferDocument> _xferDocuments;
+
+protected:
+  // The session being resumed, which the inferior's output is forwarded to.
+  // Output may come in from another thread, see appendOutput().
   std::mutex _resumeSessionLock;
   Session *_resumeSession;
   std::string _consoleBuffer;
@@ -107,6 +124,9 @@ protected:
                        std::string const &annex, uint64_t offset,
                        uint64_t length, std::string &buffer,
                        bool &last) override;
+  ErrorCode generateXferDocument(Session &session, std::string const &object,
+                                 std::string const &annex,
+                                 std::string &document, bool &stopScoped);
 
 protected:
   ErrorCode onSetStdFile(Session &session, int fileno,
@@ -181,9 +201,11 @@ protected:
 protected:
   Target::Thread *findThread(ProcessThreadId const &ptid) const;
   ErrorCode queryStopInfo(Session &session, Target::Thread *thread,
-                          StopInfo &stop) const;
+                          StopInfo &stop, bool listThreads = true,
+                          bool refreshThreadState = false) const;
   ErrorCode queryStopInfo(Session &session, ProcessThreadId const &ptid,
-                          StopInfo &stop) const;
+                          StopInfo &stop,
+                          bool refreshThreadState = false) const;
 
 protected:
   ErrorCode fetchStopInfoForAllThreads(Session &session,
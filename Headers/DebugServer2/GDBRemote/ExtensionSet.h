@@ -43,6 +43,7 @@ public:
     kVForkEvents = (1u << 16),
     kQXferOSDataRead = (1u << 17),
     kQXferThreadsRead = (1u << 18),
+    kAugmentedLibrariesSVR4Read = (1u << 19),
   };
 
 public:
@@ -150,6 +151,7 @@ private:
       {kVForkEvents, "vfork-events"},
       {kQXferOSDataRead, "qXfer:osdata:read"},
       {kQXferThreadsRead, "qXfer:threads:read"},
+      {kAugmentedLibrariesSVR4Read, "augmented-libraries-svr4-read"},
   };
 
 private:
@@ -12,19 +12,40 @@
 
 #include "DebugServer2/Types.h"
 
+#include <string_view>
+
 namespace ds2 {
 namespace GDBRemote {
 
 struct PacketProcessorDelegate;
 
 class PacketProcessor {
+public:
+  // Handed to the delegate in place of a packet that was too large to be
+  // buffered. Payloads end at the first '#', so no packet can look like it.
+  static constexpr std::string_view kOversizedPacket = "#";
+
 public:
   virtual ~PacketProcessor() {}
 
 protected:
-  std::string _buffer;
-  size_t _nreqs;
-  bool _needhash;
+  enum State {
+    kStateIdle,
+    kStatePayload,
+    kStateChecksumHigh,
+    kStateChecksumLow,
+  };
+
+protected:
+  State _state;
+  // Payload of a packet split across several reads. Packets that arrive
+  // in a single read are handed to the delegate in place.
+  std::string _partial;
+  size_t _length;
+  size_t _maxPayloadSize;
+  uint8_t _checksum;
+  int _expectedChecksum;
+  bool _verifyChecksums;
   PacketProcessorDelegate *_delegate;
 
 public:
@@ -39,19 +60,27 @@ public:
   }
 
 public:
-  void parse(std::string const &data);
+  // Checksums may be ignored once acknowledgments have been turned off.
+  inline void setVerifyChecksums(bool verify) { _verifyChecksums = verify; }
 
-private:
-  void process();
+public:
+  // Payloads longer than this are dropped rather than buffered and reported
+  // as kOversizedPacket. Zero means unlimited.
+  inline void setMaxPayloadSize(size_t size) { _maxPayloadSize = size; }
 
-private:
-  bool validate();
+protected:
+  inline bool overflow() const {
+    return _maxPayloadSize != 0 && _length > _maxPayloadSize;
+  }
+
+public:
+  void parse(std::string_view data);
 };
 
 struct PacketProcessorDelegate {
   virtual ~PacketProcessorDelegate() {}
-  virtual void onPacketData(std::string const &data, bool valid) = 0;
-  virtual void onInvalidData(std::string const &data) = 0;
+  virtual void onPacketData(std::string_view data, bool valid) = 0;
+  virtual void onInvalidData(std::string_view data) = 0;
 };
 } // namespace GDBRemote
 } // namespace ds2
@@ -11,62 +11,52 @@
 #pragma once
 
 #include "DebugServer2/Types.h"
-#include "DebugServer2/Utils/Log.h"
 
-#include <algorithm>
-#include <sstream>
+#include <string>
+#include <string_view>
 
 namespace ds2 {
 namespace GDBRemote {
 
-template <typename T> uint8_t Checksum(T const &data) {
-  uint8_t csum = 0;
-  for (char n : data) {
-    csum += n;
-  }
-  return csum;
-}
+//
+// These run on every packet that goes through a session, including binary
+// replies of several megabytes, and have vectorized implementations where
+// the target provides SSE2 or NEON.
+//
 
-template <typename T> std::string Escape(T const &data) {
-  std::ostringstream ss;
-  auto first = data.begin();
-  auto last = data.begin();
-  static std::string const searchStr = "$#}*";
+uint8_t Checksum(std::string_view data);
 
-  while ((last = std::find_first_of(first, data.end(), searchStr.begin(),
-                                    searchStr.end())) != data.end()) {
-    while (first < last) {
-      ss << *first++;
-    }
-    ss << '}' << static_cast<char>(*last - 0x20);
-    first = ++last;
-  }
+// Returns the offset of the first of $, #, } or * at or after `offset`, or
+// data.size() if there is none.
+size_t FindEscapable(std::string_view data, size_t offset = 0);
 
-  while (first < data.end()) {
-    ss << *first++;
-  }
+// Same as FindEscapable, but when `runs` is set also stops at the first byte
+// that is repeated by the byte following it.
+size_t FindEscapableOrRun(std::string_view data, size_t offset, bool runs);
 
-  return ss.str();
-}
+// Returns how many bytes from the start of `data` fit in `budget` bytes once
+// escaped.
+size_t EscapedPrefixLength(std::string_view data, size_t budget);
 
-template <typename T> std::string Unescape(T const &data) {
-  std::ostringstream ss;
-  auto first = data.begin();
-  auto last = data.begin();
+// Append the escaped (resp. unescaped) form of `data` to `out`.
+void Escape(std::string_view data, std::string &out);
+void Unescape(std::string_view data, std::string &out);
 
-  while ((last = std::find(first, data.end(), '}')) != data.end()) {
-    while (first < last) {
-      ss << *first++;
-    }
-    ss << static_cast<char>(*(last + 1) + 0x20);
-    last += 2, first = last;
-  }
+inline std::string Escape(std::string_view data) {
+  std::string result;
+  Escape(data, result);
+  return result;
+}
 
-  while (first < data.end()) {
-    ss << *first++;
-  }
+inline std::string Escape(ByteVector const &data) {
+  return Escape(std::string_view(reinterpret_cast<char const *>(data.data()),
+                                 data.size()));
+}
 
-  return ss.str();
+inline std::string Unescape(std::string_view data) {
+  std::string result;
+  Unescape(data, result);
+  return result;
 }
 } // namespace GDBRemote
 } // namespace ds2
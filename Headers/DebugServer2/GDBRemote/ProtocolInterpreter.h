@@ -12,7 +12,9 @@
 
 #include "DebugServer2/GDBRemote/PacketProcessor.h"
 
+#include <atomic>
 #include <string_view>
+#include <unordered_map>
 
 namespace ds2 {
 namespace GDBRemote {
@@ -43,6 +45,23 @@ private:
   Handler::Collection _handlers;
   std::vector<std::string> _lastCommands;
 
+  //
+  // Lookup tables into _handlers, rebuilt whenever a handler is registered
+  // (i.e. when the session is constructed): a hash of the exact commands,
+  // and the few commands that only need to prefix the packet.
+  //
+  std::unordered_map<std::string_view, Handler const *> _exactHandlers;
+  std::vector<Handler const *> _prefixHandlers;
+
+  //
+  // Reused to build the arguments passed to handlers. Interrupts are
+  // dispatched from the session thread while a handler may still be running
+  // on the main thread; the dispatch that finds them in use allocates.
+  //
+  std::string _arguments;
+  std::string _unescapedArguments;
+  std::atomic<bool> _argumentsInUse;
+
 public:
   ProtocolInterpreter();
 
@@ -67,12 +86,13 @@ public:
   }
 
 private:
+  void indexHandlers();
   Handler const *findHandler(std::string_view command,
                              size_t &commandLength) const;
 
 public:
-  void onPacketData(std::string const &data, bool valid) override;
-  void onInvalidData(std::string const &data) override;
+  void onPacketData(std::string_view data, bool valid) override;
+  void onInvalidData(std::string_view data) override;
 
 public:
   inline std::vector<std::string> const &lastCommands() const {
@@ -15,6 +15,8 @@
 
 #include <functional>
 #include <map>
+#include <string_view>
+#include <vector>
 
 namespace ds2 {
 namespace GDBRemote {
@@ -23,6 +25,13 @@ class Session : public SessionBase {
 protected:
   std::map<char, ProcessThreadId> _ptids;
   bool _threadsInStopReply;
+  // Threads snapshotted by qfThreadInfo, sent in as few replies as the
+  // packet size allows by it and the qsThreadInfo that follow.
+  struct {
+    std::vector<ThreadId> tids;
+    size_t next = 0;
+    std::string reply;
+  } _threadList;
 
 public:
   Session(CompatibilityMode mode);
@@ -65,6 +74,8 @@ private:
                       std::string const &);
   void Handle_QDisableRandomization(ProtocolInterpreter::Handler const &,
                                     std::string const &);
+  void Handle_QEnableCompression(ProtocolInterpreter::Handler const &,
+                                 std::string const &);
   void Handle_QEnvironment(ProtocolInterpreter::Handler const &,
                            std::string const &);
   void Handle_QEnvironmentHexEncoded(ProtocolInterpreter::Handler const &,
@@ -230,9 +241,18 @@ private:
   static bool ParseList(std::string const &string, char separator,
                         std::function<void(std::string const &)> const &cb);
 
+private:
+  // Decode a hex-encoded argument, replying with an error if it isn't valid
+  // hex, in which case the handler has nothing left to do.
+  bool decodeHexArgument(std::string_view hex, std::string &result);
+  bool decodeHexArgument(std::string_view hex, ByteVector &result);
+
 private:
   OpenFlags ConvertOpenFlags(uint32_t protocolFlags);
 
+private:
+  void sendThreadList();
+
 private:
   bool parseAddress(Address &address, const char *ptr, char **eptr,
                     Endian endianness) const;
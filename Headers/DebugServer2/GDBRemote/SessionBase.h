@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "DebugServer2/GDBRemote/Compression.h"
 #include "DebugServer2/GDBRemote/PacketProcessor.h"
 #include "DebugServer2/GDBRemote/ProtocolHelpers.h"
 #include "DebugServer2/GDBRemote/ProtocolInterpreter.h"
@@ -17,16 +18,24 @@
 #include "DebugServer2/Host/Channel.h"
 #include "DebugServer2/Utils/Log.h"
 
-#include <algorithm>
-#include <iomanip>
-#include <sstream>
-#include <type_traits>
+#include <atomic>
+#include <string_view>
 
 namespace ds2 {
 namespace GDBRemote {
 
 class SessionDelegate;
 
+// Largest packet we accept, advertised as PacketSize, and the largest reply
+// we send until the debugger gives its own limit with QSetMaxPacketSize.
+static size_t const kDefaultMaxPacketSize = 0x20000;
+
+// Smaller sizes don't leave replies that can be split any room to progress.
+static size_t const kMinPacketSize = 0x40;
+
+// The $ and #xx that frame every packet.
+static size_t const kPacketFramingSize = 4;
+
 class SessionBase : public ProtocolHandler {
 private:
   Host::Channel *_channel;
@@ -36,7 +45,24 @@ private:
 protected:
   SessionDelegate *_delegate;
   bool _ackmode;
+  // Set between receiving a command and either replying to it or flushing.
+  // Interrupts are handled on the session thread, hence atomic.
+  std::atomic<bool> _pendingAck;
+  bool _runLengthEncoding;
   CompatibilityMode _compatMode;
+  struct {
+    CompressionType type = kCompressionTypeNone;
+    size_t minSize = kDefaultCompressionMinSize;
+  } _compression;
+  struct {
+    size_t receive = kDefaultMaxPacketSize;
+    size_t send = kDefaultMaxPacketSize;
+  } _packetSize;
+  // Reused across packets so that framing a reply doesn't allocate.
+  std::string _sendBuffer;
+  std::string _payloadBuffer;
+  // Swapped with the session thread's queue slots, see MessageQueue.
+  std::string _receiveBuffer;
 
 public:
   SessionBase(CompatibilityMode mode);
@@ -59,46 +85,20 @@ public:
 
 public:
   bool receive(bool cooked);
-  bool parse(std::string const &data);
+  bool parse(std::string_view data);
 
 public:
-  bool send(char const *data, bool escaped = false) {
-    return send(std::string(data), escaped);
+  bool send(std::string_view data, bool escaped = false);
+  bool send(ByteVector const &data, bool escaped = false) {
+    return send(std::string_view(reinterpret_cast<char const *>(data.data()),
+                                 data.size()),
+                escaped);
   }
 
-  template <typename T> bool send(T const &data, bool escaped = false) {
-    std::ostringstream ss;
-    static std::string const searchStr = "$#}*";
-    uint8_t csum;
-
-    ss << '$';
-
-    //
-    // If data contains $, #, } or * we need to escape the
-    // stream.
-    //
-    if (!escaped &&
-        std::find_first_of(data.begin(), data.end(), searchStr.begin(),
-                           searchStr.end()) != data.end()) {
-      std::string encoded = Escape(data);
-      ss << encoded;
-      csum = Checksum(encoded);
-    } else {
-      for (char c : data) {
-        ss << c;
-      }
-      csum = Checksum(data);
-    }
-
-    ss << '#' << std::hex << std::setw(2) << std::setfill('0')
-       << (unsigned)csum;
-
-    std::string final_data = ss.str();
-    DS2LOG(Packet, "putpkt(\"%s\", %u)", final_data.c_str(),
-           (unsigned)final_data.length());
-
-    return _channel->send(final_data);
-  }
+public:
+  // Sends whatever is still held back for the current command. Must be called
+  // before blocking for something other than producing the reply.
+  bool flush();
 
 protected:
   bool sendACK();
@@ -110,7 +110,47 @@ public:
   inline bool getAckMode() { return _ackmode; }
 
 protected:
-  inline void setAckMode(bool enabled) { _ackmode = enabled; }
+  inline void setAckMode(bool enabled) {
+    _ackmode = enabled;
+    _processor.setVerifyChecksums(enabled);
+  }
+
+protected:
+  inline void setCompression(CompressionType type, size_t minSize) {
+    _compression.type = type;
+    _compression.minSize = minSize;
+  }
+
+public:
+  // Sets both the size of the packets we accept and of the replies we send.
+  inline void setMaxPacketSize(size_t size) {
+    _packetSize.receive = size;
+    _packetSize.send = size;
+    _processor.setMaxPayloadSize(size - kPacketFramingSize);
+  }
+  inline size_t getMaxPacketSize() const { return _packetSize.receive; }
+
+  // Room left for the payload of a reply once it has been framed, including
+  // the N or C prefix of compressed packets. Replies that can be split must
+  // not go beyond this.
+  inline size_t getMaxReplyPayloadSize() const {
+    size_t framing = kPacketFramingSize;
+    if (_compression.type != kCompressionTypeNone) {
+      framing++;
+    }
+    return _packetSize.send - framing;
+  }
+
+protected:
+  inline void setMaxReplySize(size_t size) { _packetSize.send = size; }
+
+public:
+  inline bool getRunLengthEncoding() { return _runLengthEncoding; }
+
+protected:
+  inline void setRunLengthEncoding(bool enabled) {
+    _runLengthEncoding = enabled;
+  }
 
 public:
   inline ProtocolInterpreter &interpreter() const {
@@ -122,7 +162,7 @@ protected:
   virtual bool onACK();
   virtual bool onNAK();
   virtual bool onCommandReceived(bool valid);
-  virtual void onInvalidData(std::string const &data);
+  virtual void onInvalidData(std::string_view data);
 };
 } // namespace GDBRemote
 } // namespace ds2
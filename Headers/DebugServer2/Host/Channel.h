@@ -28,6 +28,11 @@ public:
 public:
   virtual bool wait(int ms = -1) = 0;
 
+public:
+  // The descriptor that becomes readable when data comes in, for channels
+  // that can be polled along with others; -1 otherwise.
+  virtual int descriptor() const { return -1; }
+
 public:
   virtual ssize_t send(void const *buffer, size_t length) = 0;
   virtual ssize_t receive(void *buffer, size_t length) = 0;
@@ -35,6 +40,16 @@ public:
 public:
   virtual bool send(std::string const &buffer);
   virtual bool receive(std::string &buffer);
+
+public:
+  struct Buffer {
+    void const *data;
+    size_t length;
+  };
+
+  // Sends the buffers back to back, as a single write where the channel
+  // supports it.
+  virtual bool sendv(Buffer const *buffers, size_t count);
 };
 } // namespace Host
 } // namespace ds2
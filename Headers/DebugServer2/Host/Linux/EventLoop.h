@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include <functional>
+
+namespace ds2 {
+namespace Host {
+namespace Linux {
+
+//
+// The one epoll(7) set the debug server sleeps in. The client connection,
+// the inferior's terminal, SIGCHLD and wake-ups are all registered here, and
+// whoever waits (the session between commands, the process while it runs)
+// dispatches whatever is ready, so that everything is handled on the main
+// thread without any of it having a thread of its own.
+//
+// Descriptors are level-triggered; handlers only have to consume what they
+// can without blocking and may add or remove descriptors, including their
+// own.
+//
+class EventLoop {
+public:
+  typedef std::function<void()> Handler;
+
+public:
+  static bool Add(int fd, Handler handler);
+  static void Remove(int fd);
+
+public:
+  // Sleeps until a descriptor is ready or `ms` milliseconds went by (forever
+  // if negative) and runs the handlers of the ready ones. Returns false if
+  // there was nothing to wait on or waiting failed.
+  static bool Wait(int ms = -1);
+};
+} // namespace Linux
+} // namespace Host
+} // namespace ds2
@@ -28,8 +28,19 @@ public:
 
 public:
   ErrorCode traceMe(bool disableASLR) override;
+  ErrorCode traceChild(ProcessId pid, int *status) override;
   ErrorCode traceThat(ProcessId pid) override;
 
+public:
+  ErrorCode attach(ProcessId pid) override;
+
+public:
+  // Tracees are attached with PTRACE_SEIZE: suspend() asks for a
+  // PTRACE_EVENT_STOP with PTRACE_INTERRUPT instead of sending SIGSTOP, and
+  // listen() restarts a thread in group-stop without letting it run.
+  ErrorCode suspend(ProcessThreadId const &ptid) override;
+  ErrorCode listen(ProcessThreadId const &ptid);
+
 public:
   ErrorCode kill(ProcessThreadId const &ptid, int signal) override;
 
@@ -28,10 +28,15 @@ public:
 
 public:
   bool wait(int ms = -1) override;
+  int descriptor() const override { return fd_; }
+
+private:
+  bool waitWritable();
 
 public:
   ssize_t send(void const *buffer, size_t length) override;
   ssize_t receive(void *buffer, size_t length) override;
+  bool sendv(Buffer const *buffers, size_t count) override;
 };
 
 }
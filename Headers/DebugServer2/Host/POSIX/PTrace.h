@@ -34,6 +34,9 @@ public:
 
 public:
   virtual ErrorCode traceMe(bool disableASLR);
+  // Waits for the first stop of a child that called traceMe(), which is
+  // after it exec'd.
+  virtual ErrorCode traceChild(ProcessId pid, int *status);
   virtual ErrorCode traceThat(ProcessId pid) = 0;
 
 public:
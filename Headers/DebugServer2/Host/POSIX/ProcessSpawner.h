@@ -122,6 +122,8 @@ public:
 
 private:
   void redirectionThread();
+  ssize_t forwardOutput(RedirectDescriptor &descriptor);
+  void closeRedirections();
 };
 } // namespace Host
 } // namespace ds2
@@ -24,6 +24,9 @@ namespace Host {
 class Platform {
 public:
   static void Initialize();
+#if defined(OS_POSIX)
+  static void RestoreInitialSignalMask();
+#endif
 
 public:
   static CPUType GetCPUType();
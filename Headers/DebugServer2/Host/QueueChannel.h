@@ -48,6 +48,7 @@ public:
 public:
   ssize_t send(void const *buffer, size_t length) override;
   ssize_t receive(void *buffer, size_t length) override;
+  bool sendv(Buffer const *buffers, size_t count) override;
 
 public:
   bool receive(std::string &buffer) override;
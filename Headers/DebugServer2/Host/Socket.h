@@ -38,6 +38,7 @@ protected:
   SOCKET _handle;
   State _state;
   int _lastError;
+  bool _lowLatency;
 
 public:
   Socket();
@@ -55,6 +56,9 @@ public:
   // socket's handle to a relaunched child process (there is no fork() to
   // rely on there); see Sources/main.cpp's Windows SlaveMain.
   inline SOCKET native_handle() const { return _handle; }
+#if defined(OS_POSIX)
+  int descriptor() const override { return _handle; }
+#endif
 
 public:
   inline bool listening() const { return (_state == State::Listening); }
@@ -86,12 +90,22 @@ public:
 public:
   bool wait(int ms = -1) override;
 
+private:
+  bool waitWritable();
+
 public:
   bool setNonBlocking();
 
+public:
+  // Favors round-trip time over throughput and CPU usage: no Nagle, no
+  // delayed ACKs, socket buffers of `bufferSize` and busy polling where the
+  // system allows it. Options that don't apply to the socket are skipped.
+  bool setLowLatency(size_t bufferSize);
+
 public:
   ssize_t send(void const *buffer, size_t length) override;
   ssize_t receive(void *buffer, size_t length) override;
+  bool sendv(Buffer const *buffers, size_t count) override;
 };
 } // namespace Host
 } // namespace ds2
@@ -13,6 +13,8 @@
 #include "DebugServer2/Host/Linux/PTrace.h"
 #include "DebugServer2/Target/POSIX/ELFProcess.h"
 
+#include <atomic>
+
 namespace ds2 {
 namespace Target {
 namespace Linux {
@@ -21,21 +23,57 @@ class Process : public POSIX::ELFProcess {
 protected:
   Host::Linux::PTrace _ptrace;
 
+  // /proc/<pid>/mem, opened on first use. It is bound to the address space
+  // the process had when it was opened and has to be reopened after exec.
+  // It is opened read-only when we aren't allowed to write to it.
+  struct {
+    int fd = -1;
+    bool writable = false;
+    bool unavailable = false;
+  } _memFile;
+
+  // Parsed /proc/<pid>/maps, sorted by address. Only valid while stopped.
+  struct {
+    std::vector<MemoryRegionInfo> regions;
+    bool valid = false;
+  } _memoryMap;
+
+  // wait() sleeps in the event loop, where SIGCHLD comes in through a
+  // signalfd and interrupt() wakes it up through an eventfd, so that it also
+  // keeps serving the client and the inferior's terminal in the meantime.
+  struct {
+    int signal = -1;
+    int interrupt = -1;
+    std::atomic<bool> interrupted{false};
+  } _events;
+
+public:
+  ~Process() override;
+
 protected:
   ErrorCode attach(int waitStatus) override;
 
 public:
   ErrorCode interrupt() override;
   ErrorCode terminate() override;
+  ErrorCode suspend() override;
   bool isAlive() const override;
 
 public:
   ErrorCode getMemoryRegionInfo(Address const &address,
                                 MemoryRegionInfo &info) override;
+  void invalidateMemoryCache() override;
+
+protected:
+  ErrorCode updateMemoryMap();
 
 protected:
   ErrorCode executeCode(ByteVector const &codestr, uint64_t &result);
 
+protected:
+  ErrorCode fetchMemory(uint64_t address, void *data, size_t length,
+                        size_t *count);
+
 public:
   ErrorCode readMemory(Address const &address, void *data, size_t length,
                        size_t *count = nullptr) override;
@@ -50,6 +88,14 @@ public:
 protected:
   ErrorCode checkMemoryErrorCode(uint64_t address);
 
+protected:
+  int memoryFile(bool write = false);
+  void closeMemoryFile();
+
+protected:
+  ErrorCode createEventLoop();
+  ThreadId waitForEvent(int *status);
+
 public:
   ErrorCode wait() override;
 
@@ -58,6 +104,7 @@ public:
 
 protected:
   ErrorCode updateInfo() override;
+  ErrorCode refreshInfo() override;
   ErrorCode updateAuxiliaryVector() override;
 
 protected:
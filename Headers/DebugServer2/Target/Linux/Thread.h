@@ -19,13 +19,35 @@ namespace Target {
 namespace Linux {
 
 class Thread : public ds2::Target::POSIX::Thread {
+protected:
+  // How the next PTRACE_EVENT_STOP is reported when we asked for it; stops
+  // we only use to hold the thread (kReasonNone) aren't reported.
+  StopInfo::Reason _interruptReason = StopInfo::kReasonNone;
+  bool _groupStopped = false;
+  // Read back from /proc on request, at most once per stop (see name() and
+  // core()); the name is kept across stops as it rarely changes.
+  mutable std::string _name;
+  mutable int _core = -1;
+  mutable bool _procStateFresh = false;
+
 protected:
   friend class Process;
   Thread(Process *process, ThreadId tid);
 
+public:
+  ErrorCode resume(int signal = 0, Address const &address = Address()) override;
+  ErrorCode suspend() override;
+
+public:
+  std::string name(bool refresh = true) const override;
+  int core(bool refresh = true) const override;
+
 protected:
   ErrorCode updateStopInfo(int waitStatus) override;
   void updateState() override;
+
+private:
+  void readProcState() const;
 };
 } // namespace Linux
 } // namespace Target
@@ -18,10 +18,35 @@ namespace Target {
 namespace POSIX {
 
 class ELFProcess : public POSIX::Process {
+public:
+  struct LinkMapEntry {
+    SharedLibraryInfo library;
+    uint64_t nameAddress;
+  };
+
 protected:
   std::string _auxiliaryVector;
   Address _sharedLibraryInfoAddress;
 
+  // AT_* lookups, filled from the auxiliary vector on first use. Entries are
+  // laid out differently for 32-bit and 64-bit processes, and the bitness
+  // may only be guessed the first time we need it.
+  struct {
+    std::map<uint64_t, uint64_t> values;
+    bool valid = false;
+    bool is64Bit = false;
+  } _auxiliaryVectorTable;
+
+  // Model of the r_debug link map, keyed by link_map address. It is checked
+  // at most once per stop, only walked again if either end of the list moved,
+  // and then only the names of new entries are read.
+  struct {
+    std::map<uint64_t, LinkMapEntry> entries;
+    std::vector<uint64_t> order;
+    uint64_t generation = 0;
+    bool valid = false;
+  } _linkMap;
+
 public:
   ErrorCode getAuxiliaryVector(std::string &auxv) override;
   uint64_t getAuxiliaryVectorValue(uint64_t type) override;
@@ -38,7 +63,9 @@ public:
 
 protected:
   ErrorCode updateInfo() override;
+  void invalidateInfo() override;
   virtual ErrorCode updateAuxiliaryVector();
+  virtual ErrorCode updateLinkMap();
 };
 } // namespace POSIX
 } // namespace Target
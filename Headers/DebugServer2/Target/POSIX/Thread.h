@@ -23,6 +23,7 @@ protected:
 public:
   ErrorCode readCPUState(Architecture::CPUState &state) override;
   ErrorCode writeCPUState(Architecture::CPUState const &state) override;
+  ErrorCode flushCPUState() override;
 
 public:
   ErrorCode terminate() override;
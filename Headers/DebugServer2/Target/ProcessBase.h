@@ -11,9 +11,11 @@
 #pragma once
 
 #include "DebugServer2/Core/HardwareBreakpointManager.h"
+#include "DebugServer2/Core/MemoryCache.h"
 #include "DebugServer2/Core/SoftwareBreakpointManager.h"
 #include "DebugServer2/Target/ProcessDecl.h"
 #include "DebugServer2/Target/ThreadBase.h"
+#include "DebugServer2/Target/ThreadTable.h"
 
 #include <functional>
 #include <memory>
@@ -29,7 +31,7 @@ public:
     kExtensionForkEvents = (1u << 0),
     kExtensionVForkEvents = (1u << 1),
   };
-  typedef std::map<ThreadId, Thread *> IdentityMap;
+  typedef ThreadTable IdentityMap;
 
 protected:
   bool _terminated;
@@ -43,6 +45,9 @@ protected:
   Thread *_currentThread;
   mutable std::unique_ptr<SoftwareBreakpointManager> _softwareBreakpointManager;
   mutable std::unique_ptr<HardwareBreakpointManager> _hardwareBreakpointManager;
+  MemoryCache _memoryCache;
+  uint64_t _stopGeneration = 0;
+  uint64_t _execGeneration = 0;
 
 protected:
   ProcessBase();
@@ -97,7 +102,10 @@ protected:
   virtual ErrorCode initialize(ProcessId pid, uint32_t flags);
 
 public:
-  virtual ErrorCode getInfo(ProcessInfo &info);
+  // Process information is read once and kept until the process execs. The
+  // parent pid and credentials can change under a live process, so callers
+  // that report them pass `refresh` to have those re-read.
+  virtual ErrorCode getInfo(ProcessInfo &info, bool refresh = false);
 
 public: // ELF only
   virtual ErrorCode getAuxiliaryVector(std::string &auxv);
@@ -158,11 +166,30 @@ public:
   virtual ErrorCode getMemoryRegionInfo(Address const &address,
                                         MemoryRegionInfo &info) = 0;
 
+public:
+  // Memory contents and layout read while the process is stopped may be
+  // served from caches; this must be called before letting any of its
+  // threads run. It also starts a new stop generation, which other caches
+  // of inferior state can be keyed on.
+  virtual void invalidateMemoryCache() {
+    _memoryCache.clear();
+    _stopGeneration++;
+  }
+  inline uint64_t stopGeneration() const { return _stopGeneration; }
+
+public:
+  // Changes whenever the process execs. Generations are never reused, not
+  // even by other processes, so state keyed on one can't be mistaken for
+  // that of a process created later.
+  inline uint64_t execGeneration() const { return _execGeneration; }
+
 public:
   virtual void getThreadIds(std::vector<ThreadId> &tids);
 
 protected:
   virtual ErrorCode updateInfo() = 0;
+  virtual ErrorCode refreshInfo();
+  virtual void invalidateInfo();
 
 public:
   virtual SoftwareBreakpointManager *softwareBreakpointManager() const final;
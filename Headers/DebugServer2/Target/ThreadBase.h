@@ -15,6 +15,7 @@
 #include "DebugServer2/Utils/Log.h"
 
 #include <functional>
+#include <string>
 
 namespace ds2 {
 namespace Target {
@@ -29,6 +30,15 @@ protected:
   StopInfo _stopInfo;
   State _state;
 
+  // Register state of a stopped thread, fetched at most once per stop.
+  // Writes only update the cached copy and mark it dirty; the backend writes
+  // it back with flushCPUState() before the thread runs again.
+  struct {
+    Architecture::CPUState state;
+    bool valid = false;
+    bool dirty = false;
+  } _cpuStateCache;
+
 protected:
   ThreadBase(Process *process, ThreadId tid);
 
@@ -65,7 +75,20 @@ public:
       std::function<void(Architecture::CPUState &state)> action) final;
 
 public:
-  inline uint32_t core() const { return _stopInfo.core; }
+  virtual ErrorCode flushCPUState();
+  // The thread can't have run, and so can't have anything new to read back,
+  // without its pending writes being flushed first.
+  inline void invalidateCPUState() {
+    DS2ASSERT(!_cpuStateCache.dirty);
+    _cpuStateCache.valid = false;
+  }
+
+public:
+  // The thread's name and the core it last ran on (-1 if unknown). Backends
+  // that have to ask the OS for these only do so when `refresh` is set, and
+  // at most once per stop; otherwise they answer with what they already have.
+  virtual std::string name(bool refresh = true) const;
+  virtual int core(bool refresh = true) const { return _stopInfo.core; }
 
 protected:
   friend class ProcessBase;
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Target/ProcessDecl.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ds2 {
+namespace Target {
+
+//
+// Maps thread ids to threads for processes with many thousands of threads.
+// Live threads are kept in a dense array, which is what iteration walks, and
+// an open-addressing index (linear probing) maps a tid to its position in
+// that array. Removal moves the last thread into the hole, so iteration
+// order is not stable across removals.
+//
+class ThreadTable {
+public:
+  typedef std::pair<ThreadId, Thread *> Entry;
+  typedef std::vector<Entry>::iterator iterator;
+  typedef std::vector<Entry>::const_iterator const_iterator;
+
+private:
+  std::vector<Entry> _entries;
+  // Position in _entries plus one, zero for an empty slot.
+  std::vector<uint32_t> _index;
+
+public:
+  inline iterator begin() { return _entries.begin(); }
+  inline iterator end() { return _entries.end(); }
+  inline const_iterator begin() const { return _entries.begin(); }
+  inline const_iterator end() const { return _entries.end(); }
+
+public:
+  inline size_t size() const { return _entries.size(); }
+  inline bool empty() const { return _entries.empty(); }
+
+public:
+  iterator find(ThreadId tid);
+  const_iterator find(ThreadId tid) const;
+
+public:
+  // Returns false if there already is a thread with this id.
+  bool insert(ThreadId tid, Thread *thread);
+  void erase(iterator it);
+  size_t erase(ThreadId tid);
+  void clear();
+
+private:
+  size_t slot(ThreadId tid) const;
+  void grow();
+};
+} // namespace Target
+} // namespace ds2
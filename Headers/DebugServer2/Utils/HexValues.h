@@ -18,51 +18,56 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string>
+#include <string_view>
 
 namespace ds2 {
 
+// Value of each ASCII hex digit, kInvalidHexDigit for any other character.
+static uint8_t const kInvalidHexDigit = 0xff;
+extern uint8_t const kHexDigitValues[256];
+
 static inline char NibbleToHex(uint8_t byte) {
   return "0123456789abcdef"[byte & 0x0f];
 }
 
 static inline uint8_t HexToNibble(char ch) {
-  if (ch >= '0' && ch <= '9')
-    return ch - '0';
-  else if (ch >= 'a' && ch <= 'f')
-    return ch - 'a' + 10;
-  else if (ch >= 'A' && ch <= 'F')
-    return ch - 'A' + 10;
-  DS2_UNREACHABLE();
+  return kHexDigitValues[static_cast<uint8_t>(ch)];
 }
 
 static inline uint8_t HexToByte(char const *chars) {
   return (HexToNibble(chars[0]) << 4) | HexToNibble(chars[1]);
 }
 
+// Writes the 2 * size hex characters encoding `data` to `out`.
+void HexEncode(void const *data, size_t size, char *out);
+
+// Decodes the length / 2 bytes encoded by `str` to `out` and returns how
+// many were decoded before the first invalid hex digit.
+size_t HexDecode(char const *str, size_t length, void *out);
+
 template <typename T> static inline std::string ToHex(T const &vec) {
-  std::string result;
-  for (char n : vec) {
-    result += NibbleToHex(n >> 4);
-    result += NibbleToHex(n & 0x0f);
-  }
+  std::string result(vec.size() * 2, '\0');
+  HexEncode(vec.data(), vec.size(), &result[0]);
   return result;
 }
 
-static inline ByteVector HexToByteVector(std::string const &str) {
-  ByteVector result;
-  DS2ASSERT(str.size() % 2 == 0);
-  for (size_t n = 0; n < str.size(); n += 2) {
-    result.emplace_back(HexToByte(&str[n]));
+static inline bool HexToByteVector(std::string_view str, ByteVector &result) {
+  result.resize(str.size() / 2);
+  size_t count = HexDecode(str.data(), str.size(), result.data());
+  if (count != result.size() || str.size() % 2 != 0) {
+    result.resize(count);
+    return false;
   }
-  return result;
+  return true;
 }
 
-static inline std::string HexToString(std::string const &str) {
-  std::string result;
-  DS2ASSERT(str.size() % 2 == 0);
-  for (size_t n = 0; n < str.size(); n += 2) {
-    result += static_cast<char>(HexToByte(&str[n]));
+static inline bool HexToString(std::string_view str, std::string &result) {
+  result.resize(str.size() / 2);
+  size_t count = HexDecode(str.data(), str.size(), &result[0]);
+  if (count != result.size() || str.size() % 2 != 0) {
+    result.resize(count);
+    return false;
   }
-  return result;
+  return true;
 }
 } // namespace ds2
@@ -137,9 +137,10 @@ void BreakpointManager::disable(Target::Thread *thread) {
   enumerate(
       [this, thread](Site const &site) { disableLocation(site, thread); });
 
-  //
-  // Remove temporary breakpoints.
-  //
+  removeTemporaryBreakpoints();
+}
+
+void BreakpointManager::removeTemporaryBreakpoints() {
   auto it = _sites.begin();
   while (it != _sites.end()) {
     it->second.lifetime = it->second.lifetime & ~Lifetime::TemporaryOneShot;
@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Core/MemoryCache.h"
+#include "DebugServer2/Host/Platform.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ds2 {
+
+MemoryCache::MemoryCache(size_t maxPages)
+    : _pageSize(Host::Platform::GetPageSize()), _maxPages(maxPages) {}
+
+ErrorCode MemoryCache::read(Address const &address, void *data, size_t length,
+                            size_t *count, FetchCallback const &fetch) {
+  uint64_t const start = address.value();
+  uint64_t const end = start + length;
+  uint64_t const first = start & ~(_pageSize - 1);
+  uint64_t const last = (end + _pageSize - 1) & ~(_pageSize - 1);
+
+  //
+  // Don't let a single large read flush everything else; these are typically
+  // one-off dumps that wouldn't be re-read anyway.
+  //
+  if (length == 0 || end < start || last < end ||
+      (last - first) / _pageSize > _maxPages / 2)
+    return fetch(start, data, length, count);
+
+  uint8_t *bytes = static_cast<uint8_t *>(data);
+  size_t done = 0;
+
+  for (uint64_t page = first; page < last; page += _pageSize) {
+    auto it = _pages.find(page);
+    if (it == _pages.end() && _unreadable.count(page) == 0) {
+      //
+      // Fetch this page together with the missing pages following it in a
+      // single request.
+      //
+      uint64_t missing = page + _pageSize;
+      while (missing < last && _pages.find(missing) == _pages.end() &&
+             _unreadable.count(missing) == 0) {
+        missing += _pageSize;
+      }
+
+      if (_pages.size() + (missing - page) / _pageSize > _maxPages) {
+        _pages.clear();
+      }
+
+      ByteVector buffer(missing - page);
+      size_t nread = 0;
+      fetch(page, buffer.data(), buffer.size(), &nread);
+
+      for (size_t offset = 0; offset + _pageSize <= nread;
+           offset += _pageSize) {
+        _pages[page + offset].assign(buffer.begin() + offset,
+                                     buffer.begin() + offset + _pageSize);
+      }
+
+      if (nread < buffer.size()) {
+        _unreadable.insert(page + (nread & ~(_pageSize - 1)));
+      }
+
+      it = _pages.find(page);
+    }
+
+    if (it == _pages.end()) {
+      //
+      // The page can't be read as a whole (e.g. the mapping is shorter
+      // than a page or isn't readable); read what's left of the request
+      // directly so that the caller still gets its readable prefix.
+      //
+      size_t nfetched = 0;
+      ErrorCode error = fetch(start + done, bytes + done, length - done,
+                              &nfetched);
+      if (count != nullptr) {
+        *count = done + nfetched;
+      }
+      return error;
+    }
+
+    uint64_t lo = std::max(start, page);
+    uint64_t hi = std::min(end, page + _pageSize);
+    std::memcpy(bytes + (lo - start), it->second.data() + (lo - page),
+                hi - lo);
+    done += hi - lo;
+  }
+
+  if (count != nullptr) {
+    *count = done;
+  }
+  return kSuccess;
+}
+
+void MemoryCache::update(Address const &address, void const *data,
+                         size_t length) {
+  uint64_t const start = address.value();
+  uint64_t const end = start + length;
+  uint8_t const *bytes = static_cast<uint8_t const *>(data);
+
+  if (length == 0 || _pages.empty())
+    return;
+
+  for (auto it = _pages.lower_bound(start & ~(_pageSize - 1));
+       it != _pages.end() && it->first < end; ++it) {
+    uint64_t lo = std::max(start, it->first);
+    uint64_t hi = std::min(end, it->first + _pageSize);
+    std::memcpy(it->second.data() + (lo - it->first), bytes + (lo - start),
+                hi - lo);
+  }
+}
+} // namespace ds2
@@ -11,67 +11,128 @@
 #include "DebugServer2/Core/MessageQueue.h"
 #include "DebugServer2/Utils/Log.h"
 
+#include <algorithm>
 #include <chrono>
 
-// FIXME(strager): This class does not handle spurious
-// wakeups!  See http://en.wikipedia.org/wiki/Spurious_wakeup
-
 namespace ds2 {
 
-MessageQueue::MessageQueue() : _terminated(false) {}
+MessageQueue::Event::Event() : _waiting(false), _signaled(false) {}
 
-void MessageQueue::put(std::string const &message) {
-  std::lock_guard<std::mutex> guard(_lock);
-  _messages.push_back(message);
-  _ready.notify_one();
+template <typename Predicate>
+bool MessageQueue::Event::wait(int ms, Predicate ready) {
+  while (!ready()) {
+    //
+    // Say that we're about to sleep before checking one last time, so that
+    // the other side either sees us waiting or made `ready` true before our
+    // check.
+    //
+    _waiting = true;
+    if (ready()) {
+      _waiting = false;
+      break;
+    }
+
+    bool signaled = sleep(ms);
+    _waiting = false;
+    if (!signaled && ms >= 0)
+      break;
+  }
+
+  return ready();
 }
 
-std::string MessageQueue::get(int wait) {
-  std::string message;
+void MessageQueue::Event::signal() {
+  if (!_waiting.exchange(false))
+    return;
+
+  std::lock_guard<std::mutex> guard(_lock);
+  _signaled = true;
+  _cond.notify_one();
+}
 
+bool MessageQueue::Event::sleep(int ms) {
   std::unique_lock<std::mutex> lock(_lock);
-  if (_messages.empty()) {
-    if (_terminated)
-      return std::string();
-
-    if (wait < 0) {
-      _ready.wait(lock);
-    } else {
-      if (_ready.wait_for(lock, std::chrono::milliseconds(wait)) ==
-          std::cv_status::timeout)
-        return std::string();
-    }
-  }
-  if (!_messages.empty()) {
-    message = _messages.front();
-    _messages.pop_front();
+  if (ms < 0) {
+    _cond.wait(lock, [this] { return _signaled; });
+  } else {
+    _cond.wait_for(lock, std::chrono::milliseconds(ms),
+                   [this] { return _signaled; });
   }
 
-  return message;
+  bool signaled = _signaled;
+  _signaled = false;
+  return signaled;
 }
 
-bool MessageQueue::wait(int ms) {
-  std::unique_lock<std::mutex> lock(_lock);
-  if (!_messages.empty())
-    return true;
-  if (_terminated)
+MessageQueue::MessageQueue()
+    : _head(0), _tail(0), _discard(0), _reading(0), _terminated(false) {}
+
+uint64_t MessageQueue::head() const {
+  return std::max(_head.load(), _discard.load());
+}
+
+bool MessageQueue::writable(uint64_t tail) const {
+  if (tail - head() >= kCapacity)
     return false;
-  if (ms < 0) {
-    _ready.wait(lock);
-    return !_messages.empty();
-  } else {
-    std::chrono::milliseconds duration(ms);
-    return _ready.wait_for(lock, duration) != std::cv_status::timeout;
+
+  uint64_t reading = _reading.load();
+  return reading == 0 || tail - (reading - 1) < kCapacity;
+}
+
+void MessageQueue::put(std::string_view message) {
+  uint64_t tail = _tail.load(std::memory_order_relaxed);
+
+  //
+  // Slots of discarded messages can be reused right away, except for the one
+  // the consumer might be in the middle of taking.
+  //
+  _writable.wait(-1, [this, tail] { return _terminated || writable(tail); });
+  if (_terminated)
+    return;
+
+  _slots[tail % kCapacity].assign(message.data(), message.size());
+  _tail = tail + 1;
+  _readable.signal();
+}
+
+bool MessageQueue::get(std::string &message, int ms) {
+  uint64_t head;
+  for (;;) {
+    if (!wait(ms))
+      return false;
+
+    //
+    // Claim the slot before checking that it wasn't discarded in the
+    // meantime: either the producer sees our claim and leaves the slot alone,
+    // or we see the discard and go back to waiting for a new message.
+    //
+    head = this->head();
+    _reading = head + 1;
+    if (head == this->head() && head < _tail.load())
+      break;
+    _reading = 0;
+    _writable.signal();
   }
+
+  message.swap(_slots[head % kCapacity]);
+  _head = head + 1;
+  _reading = 0;
+  _writable.signal();
+  return true;
+}
+
+bool MessageQueue::wait(int ms) {
+  _readable.wait(ms, [this] { return _terminated || !empty(); });
+  return !empty();
 }
 
 void MessageQueue::clear(bool terminating) {
-  std::lock_guard<std::mutex> guard(_lock);
-  _messages.clear();
+  _discard = _tail.load();
   if (terminating) {
     DS2ASSERT(!_terminated);
     _terminated = true;
-    _ready.notify_one();
+    _readable.signal();
+    _writable.signal();
   }
 }
 } // namespace ds2
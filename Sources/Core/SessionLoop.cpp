@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Core/SessionLoop.h"
+#include "DebugServer2/Host/Linux/EventLoop.h"
+
+using ds2::GDBRemote::Session;
+using ds2::Host::Channel;
+using ds2::Host::Linux::EventLoop;
+
+SessionLoop::SessionLoop(Channel *channel, Session *session)
+    : _channel(channel), _session(session), _fd(channel->descriptor()) {
+  _pp.setDelegate(this);
+}
+
+SessionLoop::~SessionLoop() { EventLoop::Remove(_fd); }
+
+void SessionLoop::run() {
+  _pp.setMaxPayloadSize(_session->getMaxPacketSize() -
+                        ds2::GDBRemote::kPacketFramingSize);
+
+  if (_fd < 0 || !EventLoop::Add(_fd, [this]() { onReadable(); }))
+    return;
+
+  //
+  // Commands run from here, one at a time; anything that comes in while one
+  // runs was queued by onReadable().
+  //
+  std::string data;
+  while (_channel->connected()) {
+    if (_pending.empty()) {
+      if (!EventLoop::Wait())
+        break;
+      continue;
+    }
+
+    data.swap(_pending.front());
+    _pending.pop_front();
+    _session->interpreter().onPacketData(data, true);
+  }
+
+  EventLoop::Remove(_fd);
+}
+
+void SessionLoop::onReadable() {
+  if (!_channel->receive(_receiveBuffer)) {
+    // Either a spurious wake-up or the client went away, in which case the
+    // channel closed its descriptor and run() will notice.
+    if (!_channel->connected())
+      EventLoop::Remove(_fd);
+    return;
+  }
+
+  _pp.setVerifyChecksums(_session->getAckMode());
+  _pp.parse(_receiveBuffer);
+}
+
+void SessionLoop::onPacketData(std::string_view data, bool valid) {
+  if (data.length() == 1 && data[0] == '\x03') {
+    //
+    // Interrupts are handled as soon as they come in, which is usually from
+    // within Process::wait(), and pre-empt anything still queued.
+    //
+    _pending.clear();
+    _session->interpreter().onPacketData(data, valid);
+  } else if (_session->getAckMode() && !valid) {
+    //
+    // Let the session NAK invalid packets right away, that doesn't interact
+    // with the inferior.
+    //
+    _session->interpreter().onPacketData(data, valid);
+  } else {
+    _pending.emplace_back(data);
+  }
+}
+
+void SessionLoop::onInvalidData(std::string_view data) {
+  _session->interpreter().onInvalidData(data);
+}
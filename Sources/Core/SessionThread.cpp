@@ -25,6 +25,9 @@ void SessionThread::start() {
 }
 
 void SessionThread::run() {
+  _pp.setMaxPayloadSize(_session->getMaxPacketSize() -
+                        ds2::GDBRemote::kPacketFramingSize);
+
   //
   // Wait for a message and pass down to the packet processor.
   //
@@ -37,13 +40,14 @@ void SessionThread::run() {
     if (!_channel->remote()->receive(data))
       break;
 
+    _pp.setVerifyChecksums(_session->getAckMode());
     _pp.parse(data);
   }
 
   _channel->close();
 }
 
-void SessionThread::onPacketData(std::string const &data, bool valid) {
+void SessionThread::onPacketData(std::string_view data, bool valid) {
   if (data.length() == 1 && data[0] == '\x03') {
     //
     // Interrupt process, this is the highest priority message
@@ -77,7 +81,7 @@ void SessionThread::onPacketData(std::string const &data, bool valid) {
   }
 }
 
-void SessionThread::onInvalidData(std::string const &data) {
+void SessionThread::onInvalidData(std::string_view data) {
   //
   // Forward to the session's interpreter.
   //
@@ -14,7 +14,9 @@
 #include "DebugServer2/Utils/HexValues.h"
 #include "DebugServer2/Utils/Log.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 #define super ds2::BreakpointManager
 
@@ -22,11 +24,18 @@ namespace ds2 {
 
 SoftwareBreakpointManager::SoftwareBreakpointManager(
     Target::ProcessBase *process)
-    : super(process), _enabled(false) {}
+    : super(process), _enabled(false), _persistent(false) {}
 
-SoftwareBreakpointManager::~SoftwareBreakpointManager() { clear(); }
+SoftwareBreakpointManager::~SoftwareBreakpointManager() {
+  // The process is being torn down and cannot be written to anymore; opcodes
+  // left in memory have to be removed with clear() beforehand.
+  _insns.clear();
+}
 
 void SoftwareBreakpointManager::clear() {
+  // Outside of persistent mode, this is empty unless we are running.
+  enumerate([this](Site const &site) { disableLocation(site); });
+
   super::clear();
   _insns.clear();
 }
@@ -41,6 +50,10 @@ ErrorCode SoftwareBreakpointManager::enableLocation(Site const &site,
     DS2LOG(Warning, "thread-specific software breakpoints are unsupported");
   }
 
+  if (_insns.find(site.address) != _insns.end()) {
+    return kSuccess;
+  }
+
   getOpcode(site.size, opcode);
   old.resize(opcode.size());
   error = _process->readMemory(site.address, old.data(), old.size());
@@ -71,12 +84,23 @@ ErrorCode SoftwareBreakpointManager::enableLocation(Site const &site,
 ErrorCode SoftwareBreakpointManager::disableLocation(Site const &site,
                                                      Target::Thread *thread) {
   ErrorCode error;
-  ByteVector old = _insns[site.address];
 
   if (thread != nullptr) {
     DS2LOG(Warning, "thread-specific software breakpoints are unsupported");
   }
 
+  auto it = _insns.find(site.address);
+  if (it == _insns.end()) {
+    return kSuccess;
+  }
+
+  //
+  // Forget about the location before restoring it so that the write isn't
+  // seen as a write to a breakpoint site by updateMemory().
+  //
+  ByteVector old = std::move(it->second);
+  _insns.erase(it);
+
   error = _process->writeMemory(site.address, old.data(), old.size());
   if (error != kSuccess) {
     DS2LOG(Error, "cannot restore instruction at %" PRI_PTR,
@@ -87,23 +111,117 @@ ErrorCode SoftwareBreakpointManager::disableLocation(Site const &site,
   DS2LOG(Debug, "reset instruction 0x%s at %" PRI_PTR, ToHex(old).c_str(),
          PRI_PTR_CAST(site.address.value()));
 
-  _insns.erase(site.address);
-
   return kSuccess;
 }
 
 void SoftwareBreakpointManager::enable(Target::Thread *thread) {
+  if (_persistent && _enabled) {
+    //
+    // Sites added while stopped are already in memory, this only inserts
+    // those we had to forget about (e.g. after an exec).
+    //
+    enumerate(
+        [this, thread](Site const &site) { enableLocation(site, thread); });
+    return;
+  }
+
   super::enable(thread);
 
   _enabled = true;
 }
 
 void SoftwareBreakpointManager::disable(Target::Thread *thread) {
+  if (_persistent) {
+    //
+    // Only remove the sites that are about to go away; everything else stays
+    // in memory until the next resume.
+    //
+    enumerate([this, thread](Site const &site) {
+      if ((site.lifetime & ~Lifetime::TemporaryOneShot) == Lifetime::None) {
+        disableLocation(site, thread);
+      }
+    });
+    removeTemporaryBreakpoints();
+    return;
+  }
+
   super::disable(thread);
 
   _enabled = false;
 }
 
+void SoftwareBreakpointManager::maskMemory(Address const &address, void *data,
+                                           size_t length) const {
+  uint64_t start = address.value();
+  uint64_t end = start + length;
+
+  //
+  // Sites never overlap, so the only one that can start before `address` and
+  // still cover it is the one immediately preceding it.
+  //
+  auto it = _insns.upper_bound(start);
+  if (it != _insns.begin()) {
+    --it;
+  }
+
+  for (; it != _insns.end() && it->first < end; ++it) {
+    uint64_t lo = std::max(start, it->first);
+    uint64_t hi = std::min(end, it->first + it->second.size());
+    if (lo >= hi)
+      continue;
+
+    std::memcpy(static_cast<uint8_t *>(data) + (lo - start),
+                it->second.data() + (lo - it->first), hi - lo);
+  }
+}
+
+void SoftwareBreakpointManager::updateMemory(Address const &address,
+                                             void const *data, size_t length) {
+  uint64_t start = address.value();
+  uint64_t end = start + length;
+
+  auto it = _insns.upper_bound(start);
+  if (it != _insns.begin()) {
+    --it;
+  }
+
+  while (it != _insns.end() && it->first < end) {
+    uint64_t lo = std::max(start, it->first);
+    uint64_t hi = std::min(end, it->first + it->second.size());
+    if (lo >= hi) {
+      ++it;
+      continue;
+    }
+
+    //
+    // The write went over (part of) a breakpoint opcode: what was written is
+    // the new original instruction, and the opcode has to be put back. The
+    // location is taken out of _insns while doing so, so that the write of
+    // the opcode doesn't bring us back here.
+    //
+    uint64_t siteAddress = it->first;
+    ByteVector insn = std::move(it->second);
+    std::memcpy(insn.data() + (lo - siteAddress),
+                static_cast<uint8_t const *>(data) + (lo - start), hi - lo);
+    it = _insns.erase(it);
+
+    auto site = _sites.find(siteAddress);
+    if (site == _sites.end())
+      continue;
+
+    ByteVector opcode;
+    getOpcode(site->second.size, opcode);
+    if (_process->writeMemory(siteAddress, opcode.data(), opcode.size()) !=
+        kSuccess) {
+      DS2LOG(Error, "cannot re-insert breakpoint at %" PRI_PTR,
+             PRI_PTR_CAST(siteAddress));
+      continue;
+    }
+
+    _insns.emplace_hint(it, siteAddress, std::move(insn));
+  }
+}
+
 bool SoftwareBreakpointManager::enabled(Target::Thread *thread) const {
   if (thread != nullptr) {
     DS2LOG(Warning, "thread-specific software breakpoints are unsupported");
@@ -27,6 +27,14 @@ int SoftwareBreakpointManager::hit(Target::Thread *thread, Site &site) {
   if (thread->state() == Target::Thread::kStepped)
     return 0;
 
+  //
+  // A thread we interrupted without it trapping may sit just past a
+  // breakpoint (e.g. it was resumed right after stepping over one and had no
+  // chance to run), rewinding it would execute that instruction twice.
+  //
+  if (thread->stopInfo().event == StopInfo::kEventNone)
+    return -1;
+
   thread->readCPUState(state);
   state.setPC(state.pc() - 1);
 
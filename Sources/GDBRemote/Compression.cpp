@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/GDBRemote/Compression.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(HAVE_LZ4)
+#include <lz4.h>
+#endif
+
+namespace ds2 {
+namespace GDBRemote {
+
+namespace {
+
+struct CompressionName {
+  CompressionType type;
+  char const *name;
+};
+
+CompressionName const kCompressionNames[] = {
+#if defined(HAVE_ZLIB)
+    {kCompressionTypeZlibDeflate, "zlib-deflate"},
+#endif
+#if defined(HAVE_LZ4)
+    {kCompressionTypeLZ4, "lz4"},
+#endif
+    {kCompressionTypeNone, nullptr},
+};
+
+//
+// zlib-deflate is a raw deflate stream (no zlib header or trailer), which is
+// what LLDB inflates on the other end.
+//
+bool CompressZlibDeflate(std::string const &input,
+                         std::vector<uint8_t> &output) {
+#if defined(HAVE_ZLIB)
+  z_stream stream = {};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  output.resize(deflateBound(&stream, input.size()));
+  stream.next_in =
+      reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = output.data();
+  stream.avail_out = output.size();
+
+  int rc = deflate(&stream, Z_FINISH);
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+  return rc == Z_STREAM_END;
+#else
+  return false;
+#endif
+}
+
+// lz4 is a single raw LZ4 block, without the frame format.
+bool CompressLZ4(std::string const &input, std::vector<uint8_t> &output) {
+#if defined(HAVE_LZ4)
+  output.resize(LZ4_compressBound(input.size()));
+  int size = LZ4_compress_default(input.data(),
+                                  reinterpret_cast<char *>(output.data()),
+                                  input.size(), output.size());
+  if (size <= 0)
+    return false;
+
+  output.resize(size);
+  return true;
+#else
+  return false;
+#endif
+}
+} // namespace
+
+std::string SupportedCompressions() {
+  std::string result;
+  for (auto const &entry : kCompressionNames) {
+    if (entry.name == nullptr)
+      break;
+    if (!result.empty())
+      result += ',';
+    result += entry.name;
+  }
+  return result;
+}
+
+bool ParseCompressionType(std::string const &name, CompressionType &type) {
+  for (auto const &entry : kCompressionNames) {
+    if (entry.name == nullptr)
+      break;
+    if (name == entry.name) {
+      type = entry.type;
+      return true;
+    }
+  }
+  return false;
+}
+
+void FrameCompressedPayload(CompressionType type, size_t minSize,
+                            std::string const &payload, std::string &packet) {
+  std::vector<uint8_t> compressed;
+  bool success = false;
+
+  if (payload.size() > minSize) {
+    switch (type) {
+    case kCompressionTypeZlibDeflate:
+      success = CompressZlibDeflate(payload, compressed);
+      break;
+    case kCompressionTypeLZ4:
+      success = CompressLZ4(payload, compressed);
+      break;
+    case kCompressionTypeNone:
+      break;
+    }
+  }
+
+  //
+  // The compressed data is binary, escape the bytes that would otherwise
+  // terminate or alter the packet.
+  //
+  auto needsEscape = [](uint8_t byte) {
+    return byte == '#' || byte == '$' || byte == '}' || byte == '*' ||
+           byte == '\0';
+  };
+
+  //
+  // Only use the compressed form if it is smaller once framed and escaped,
+  // so that compression never makes a packet go over the negotiated size.
+  //
+  std::string header = 'C' + std::to_string(payload.size()) + ':';
+  size_t framedSize = header.size() + compressed.size();
+  if (success) {
+    for (uint8_t byte : compressed) {
+      framedSize += needsEscape(byte) ? 1 : 0;
+    }
+  }
+
+  if (!success || framedSize >= payload.size() + 1) {
+    packet += 'N';
+    packet += payload;
+    return;
+  }
+
+  packet += header;
+  for (uint8_t byte : compressed) {
+    if (needsEscape(byte)) {
+      packet += '}';
+      packet += static_cast<char>(byte ^ 0x20);
+    } else {
+      packet += static_cast<char>(byte);
+    }
+  }
+
+  DS2LOG(Packet, "compressed %zu bytes to %zu", payload.size(),
+         compressed.size());
+}
+} // namespace GDBRemote
+} // namespace ds2
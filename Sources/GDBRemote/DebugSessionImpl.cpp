@@ -11,6 +11,7 @@
 #include "DebugServer2/GDBRemote/DebugSessionImpl.h"
 #include "DebugServer2/Core/HardwareBreakpointManager.h"
 #include "DebugServer2/Core/SoftwareBreakpointManager.h"
+#include "DebugServer2/GDBRemote/Compression.h"
 #include "DebugServer2/GDBRemote/Session.h"
 #include "DebugServer2/Host/Platform.h"
 #include "DebugServer2/Utils/HexValues.h"
@@ -33,13 +34,11 @@ DebugSessionImplBase::DebugSessionImplBase(StringCollection const &args,
                                            EnvironmentBlock const &env)
     : DummySessionDelegateImpl(), _resumeSession(nullptr) {
   DS2ASSERT(args.size() >= 1);
-  _resumeSessionLock.lock();
   spawnProcess(args, env);
 }
 
 DebugSessionImplBase::DebugSessionImplBase(int attachPid)
     : DummySessionDelegateImpl(), _resumeSession(nullptr) {
-  _resumeSessionLock.lock();
   _process = ds2::Target::Process::Attach(attachPid);
   if (_process == nullptr)
     DS2LOG(Fatal, "cannot attach to pid %d", attachPid);
@@ -48,14 +47,9 @@ DebugSessionImplBase::DebugSessionImplBase(int attachPid)
 }
 
 DebugSessionImplBase::DebugSessionImplBase()
-    : DummySessionDelegateImpl(), _process(nullptr), _resumeSession(nullptr) {
-  _resumeSessionLock.lock();
-}
+    : DummySessionDelegateImpl(), _process(nullptr), _resumeSession(nullptr) {}
 
-DebugSessionImplBase::~DebugSessionImplBase() {
-  _resumeSessionLock.unlock();
-  delete _process;
-}
+DebugSessionImplBase::~DebugSessionImplBase() { delete _process; }
 
 size_t DebugSessionImplBase::getGPRSize() const {
   if (_process == nullptr)
@@ -94,6 +88,7 @@ ErrorCode DebugSessionImplBase::onQuerySupported(
 #if defined(OS_LINUX) || defined(OS_FREEBSD)
   supported(ExtensionSet::kQXferAuxvRead);
   supported(ExtensionSet::kQXferLibrariesSVR4Read);
+  supported(ExtensionSet::kAugmentedLibrariesSVR4Read);
 #elif defined(OS_WIN32)
   supported(ExtensionSet::kQXferLibrariesRead);
 #endif
@@ -162,24 +157,32 @@ ErrorCode DebugSessionImplBase::onQuerySupported(
                                      : Feature::kNotSupported);
       };
 
-  // TODO PacketSize should be respected
   static constexpr Extension kAlwaysAdvertised[] = {
       ExtensionSet::kQEcho,
       ExtensionSet::kQStartNoAckMode,
       ExtensionSet::kQXferFeaturesRead,
       ExtensionSet::kQXferAuxvRead,
       ExtensionSet::kQXferLibrariesSVR4Read,
+      ExtensionSet::kAugmentedLibrariesSVR4Read,
       ExtensionSet::kQXferLibrariesRead,
       ExtensionSet::kQListThreadsInStopReply,
       ExtensionSet::kQPassSignals,
   };
   enable(kAlwaysAdvertised[0]);
-  addFeature("PacketSize", Feature::kSupported, "3fff");
+  std::ostringstream packetSize;
+  packetSize << std::hex << session.getMaxPacketSize();
+  addFeature("PacketSize", Feature::kSupported, packetSize.str().c_str());
   for (size_t index = 1; index < sizeof(kAlwaysAdvertised) / sizeof(*kAlwaysAdvertised);
        ++index) {
     enable(kAlwaysAdvertised[index]);
   }
 
+  std::string compressions = SupportedCompressions();
+  if (!compressions.empty()) {
+    addFeature("SupportedCompressions", Feature::kSupported,
+               compressions.c_str());
+  }
+
   if (!isLLDB) {
     addFeature("ConditionalBreakpoints", Feature::kNotSupported);
 
@@ -285,7 +288,8 @@ Thread *DebugSessionImplBase::findThread(ProcessThreadId const &ptid) const {
 }
 
 ErrorCode DebugSessionImplBase::queryStopInfo(Session &session, Thread *thread,
-                                              StopInfo &stop) const {
+                                              StopInfo &stop, bool listThreads,
+                                              bool refreshThreadState) const {
   DS2ASSERT(thread != nullptr);
 
   // Directly copy the fields that are common between ds2::StopInfo and
@@ -305,8 +309,10 @@ ErrorCode DebugSessionImplBase::queryStopInfo(Session &session, Thread *thread,
 
   case StopInfo::kEventStop: {
     // Thread name won't be available if the process has exited or has been
-    // killed.
-    stop.threadName = Platform::GetThreadName(stop.ptid.pid, stop.ptid.tid);
+    // killed. Both may cost a trip to the OS per thread, which stop replies
+    // and bulk queries skip unless the thread is the one of interest.
+    stop.threadName = thread->name(refreshThreadState);
+    stop.core = thread->core(refreshThreadState);
 
     Architecture::CPUState state;
     CHK(thread->readCPUState(state));
@@ -323,21 +329,24 @@ ErrorCode DebugSessionImplBase::queryStopInfo(Session &session, Thread *thread,
     DS2BUG("impossible StopInfo event: %s", Stringify::StopEvent(stop.event));
   }
 
-  _process->enumerateThreads(
-      [&](Thread *thread) { stop.threads.insert(thread->tid()); });
+  if (listThreads) {
+    _process->enumerateThreads(
+        [&](Thread *thread) { stop.threads.insert(thread->tid()); });
+  }
 
   return kSuccess;
 }
 
 ErrorCode DebugSessionImplBase::queryStopInfo(Session &session,
                                               ProcessThreadId const &ptid,
-                                              StopInfo &stop) const {
+                                              StopInfo &stop,
+                                              bool refreshThreadState) const {
   Thread *thread = findThread(ptid);
   if (thread == nullptr) {
     return kErrorInvalidArgument;
   }
 
-  return queryStopInfo(session, thread, stop);
+  return queryStopInfo(session, thread, stop, true, refreshThreadState);
 }
 
 ErrorCode DebugSessionImplBase::onQueryThreadStopInfo(
@@ -346,7 +355,7 @@ ErrorCode DebugSessionImplBase::onQueryThreadStopInfo(
   if (thread == nullptr)
     return kErrorProcessNotFound;
 
-  return queryStopInfo(session, ptid, stop);
+  return queryStopInfo(session, ptid, stop, true);
 }
 
 ErrorCode DebugSessionImplBase::onQueryThreadList(Session &, ProcessId pid,
@@ -418,7 +427,7 @@ ErrorCode DebugSessionImplBase::onQueryProcessInfo(Session &,
   if (_process == nullptr)
     return kErrorProcessNotFound;
   else
-    return _process->getInfo(info);
+    return _process->getInfo(info, true);
 }
 
 ErrorCode
@@ -596,13 +605,60 @@ ErrorCode DebugSessionImplBase::onXferRead(Session &session,
   DS2LOG(Debug, "object='%s' annex='%s' offset=%#" PRIx64 " length=%#" PRIx64,
          object.c_str(), annex.c_str(), offset, length);
 
+  uint64_t execGeneration =
+      (_process != nullptr) ? _process->execGeneration() : 0;
+  uint64_t stopGeneration =
+      (_process != nullptr) ? _process->stopGeneration() : 0;
+
+  XferDocument &document = _xferDocuments[object];
+  bool valid = !document.data.empty() && document.annex == annex &&
+               document.mode == session.mode() &&
+               document.execGeneration == execGeneration;
+  if (valid && document.stopScoped) {
+    valid = (document.stopGeneration == stopGeneration);
+  }
+
+  if (!valid) {
+    ErrorCode error = generateXferDocument(session, object, annex,
+                                           document.data, document.stopScoped);
+    if (error != kSuccess) {
+      _xferDocuments.erase(object);
+      return error;
+    }
+
+    document.annex = annex;
+    document.mode = session.mode();
+    document.execGeneration = execGeneration;
+    document.stopGeneration = stopGeneration;
+  }
+
+  if (offset < document.data.length()) {
+    buffer = document.data.substr(offset, length);
+    if (document.data.length() - offset > length) {
+      last = false;
+    }
+  } else {
+    buffer.clear();
+  }
+
+  return kSuccess;
+}
+
+ErrorCode DebugSessionImplBase::generateXferDocument(Session &session,
+                                                     std::string const &object,
+                                                     std::string const &annex,
+                                                     std::string &buffer,
+                                                     bool &stopScoped) {
   // TODO Split these generators into appropriate functions
+  stopScoped = true;
   if (object == "features") {
+    // Register descriptions only depend on the target architecture.
+    stopScoped = false;
     if (session.mode() == kCompatibilityModeLLDB) {
       Architecture::LLDBDescriptor const *desc =
           _process->getLLDBRegistersDescriptor();
       if (annex == "target.xml") {
-        buffer = Architecture::LLDBGenerateXMLMain(*desc).substr(offset);
+        buffer = Architecture::LLDBGenerateXMLMain(*desc);
       } else {
         std::ostringstream ss;
         ss << Architecture::GenerateXMLHeader();
@@ -622,22 +678,19 @@ ErrorCode DebugSessionImplBase::onXferRead(Session &session,
           ss << '\t' << info.encode(setNum) << '\n';
         }
         ss << "</feature>" << std::endl;
-        buffer = ss.str().substr(offset);
+        buffer = ss.str();
       }
     } else {
       Architecture::GDBDescriptor const *desc =
           _process->getGDBRegistersDescriptor();
       if (annex == "target.xml") {
-        buffer = Architecture::GDBGenerateXMLMain(*desc).substr(offset);
+        buffer = Architecture::GDBGenerateXMLMain(*desc);
       } else {
-        buffer = Architecture::GDBGenerateXMLFeatureByFileName(*desc, annex)
-                     .substr(offset);
+        buffer = Architecture::GDBGenerateXMLFeatureByFileName(*desc, annex);
       }
     }
   } else if (object == "auxv") {
     CHK(_process->getAuxiliaryVector(buffer));
-
-    buffer = buffer.substr(offset);
   } else if (object == "threads") {
     std::ostringstream ss;
 
@@ -646,14 +699,17 @@ ErrorCode DebugSessionImplBase::onXferRead(Session &session,
     _process->enumerateThreads([&](Thread *thread) {
       ss << "<thread "
          << "id=\"p" << std::hex << _process->pid() << '.' << std::hex
-         << thread->tid() << "\" "
-         << "core=\"" << std::dec << thread->core() << "\""
-         << "/>" << std::endl;
+         << thread->tid() << "\"";
+      int core = thread->core();
+      if (core >= 0) {
+        ss << " core=\"" << std::dec << core << "\"";
+      }
+      ss << "/>" << std::endl;
     });
 
     ss << "</threads>" << std::endl;
 
-    buffer = ss.str().substr(offset);
+    buffer = ss.str();
   } else if (object == "libraries") {
     std::ostringstream ss;
 
@@ -673,26 +729,61 @@ ErrorCode DebugSessionImplBase::onXferRead(Session &session,
     });
 
     ss << "</library-list>";
-    buffer = ss.str().substr(offset);
+    buffer = ss.str();
   } else if (object == "libraries-svr4") {
     std::ostringstream ss;
     std::ostringstream sslibs;
     Address mainMapAddress;
 
+    //
+    // The augmented form takes a "start=<lm>;prev=<lm>" annex to only list
+    // the objects from `start` on, `prev` being the one before it. If `prev`
+    // doesn't match what we have, the debugger's view is stale and it gets
+    // an empty list, like gdbserver does.
+    //
+    uint64_t startAddress = 0;
+    uint64_t prevAddress = 0;
+    std::istringstream annexArgs(annex);
+    std::string arg;
+    while (std::getline(annexArgs, arg, ';')) {
+      if (arg.compare(0, 6, "start=") == 0) {
+        startAddress = std::strtoull(arg.c_str() + 6, nullptr, 16);
+      } else if (arg.compare(0, 5, "prev=") == 0) {
+        prevAddress = std::strtoull(arg.c_str() + 5, nullptr, 16);
+      }
+    }
+
+    bool listing = (startAddress == 0);
+    bool stale = false;
+    uint64_t lastAddress = 0;
+
     _process->enumerateSharedLibraries([&](SharedLibraryInfo const &library) {
+      if (!listing && !stale) {
+        if (library.svr4.mapAddress == startAddress) {
+          listing = true;
+          stale = (lastAddress != prevAddress);
+        }
+        lastAddress = library.svr4.mapAddress;
+      }
+
+      // The main executable is never listed as a library, but the debugger
+      // needs main-lm whatever part of the list it asked for.
       if (library.main) {
         mainMapAddress = library.svr4.mapAddress;
-      } else {
-        sslibs << "<library "
-               << "name=\"" << library.path << "\" "
-               << "lm=\""
-               << "0x" << std::hex << library.svr4.mapAddress << "\" "
-               << "l_addr=\""
-               << "0x" << std::hex << library.svr4.baseAddress << "\" "
-               << "l_ld=\""
-               << "0x" << std::hex << library.svr4.ldAddress << "\" "
-               << "/>" << std::endl;
+        return;
       }
+      if (!listing || stale)
+        return;
+
+      sslibs << "<library "
+             << "name=\"" << library.path << "\" "
+             << "lm=\""
+             << "0x" << std::hex << library.svr4.mapAddress << "\" "
+             << "l_addr=\""
+             << "0x" << std::hex << library.svr4.baseAddress << "\" "
+             << "l_ld=\""
+             << "0x" << std::hex << library.svr4.ldAddress << "\" "
+             << "/>" << std::endl;
     });
 
     ss << "<library-list-svr4 version=\"1.0\"";
@@ -703,16 +794,11 @@ ErrorCode DebugSessionImplBase::onXferRead(Session &session,
     ss << ">" << std::endl;
     ss << sslibs.str();
     ss << "</library-list-svr4>";
-    buffer = ss.str().substr(offset);
+    buffer = ss.str();
   } else {
     return kErrorUnsupported;
   }
 
-  if (buffer.length() > length) {
-    buffer.resize(length);
-    last = false;
-  }
-
   return kSuccess;
 }
 
@@ -886,8 +972,22 @@ ErrorCode DebugSessionImplBase::onReadMemory(Session &, Address const &address,
                                              size_t length, ByteVector &data) {
   if (_process == nullptr)
     return kErrorProcessNotFound;
-  else
-    return _process->readMemoryBuffer(address, length, data);
+
+  //
+  // m and x replies may be shorter than requested; debuggers probing near
+  // the end of a mapping expect the readable prefix rather than an error.
+  //
+  data.resize(length);
+
+  size_t nread = 0;
+  ErrorCode error = _process->readMemory(address, data.data(), length, &nread);
+  if (error != kSuccess && nread == 0) {
+    data.clear();
+    return error;
+  }
+
+  data.resize(nread);
+  return kSuccess;
 }
 
 ErrorCode DebugSessionImplBase::onWriteMemory(Session &, Address const &address,
@@ -991,10 +1091,16 @@ DebugSessionImplBase::onResume(Session &session,
   bool hasGlobalAction = false;
   std::set<Thread *> excluded;
 
+  _resumeSessionLock.lock();
   DS2ASSERT(_resumeSession == nullptr);
   _resumeSession = &session;
   _resumeSessionLock.unlock();
 
+  // The stop reply may be a long time coming, acknowledge the command now,
+  // along with any output that came in while the process was stopped.
+  session.flush();
+  appendOutput(nullptr, 0);
+
   error = _process->beforeResume();
   if (error != kSuccess)
     goto ret;
@@ -1144,6 +1250,7 @@ DebugSessionImplBase::onResume(Session &session,
 ret:
   _resumeSessionLock.lock();
   _resumeSession = nullptr;
+  _resumeSessionLock.unlock();
   return error;
 }
 
@@ -1359,19 +1466,27 @@ void DebugSessionImplBase::applyEnabledExtensionsToProcess() const {
   _process->setEnabledExtensions(processExtensions);
 }
 
+//
+// Output is forwarded a line at a time, and only while the process runs;
+// what comes in while it is stopped waits for the next resume.
+//
 void DebugSessionImplBase::appendOutput(char const *buf, size_t size) {
-  for (size_t i = 0; i < size; ++i) {
-    this->_consoleBuffer += buf[i];
-    if (buf[i] == '\n') {
-      _resumeSessionLock.lock();
-      DS2ASSERT(_resumeSession != nullptr);
-      std::string data = "O";
-      data += ToHex(this->_consoleBuffer);
-      _consoleBuffer.clear();
-      this->_resumeSession->send(data);
-      _resumeSessionLock.unlock();
-    }
+  std::lock_guard<std::mutex> guard(_resumeSessionLock);
+  if (size > 0) {
+    _consoleBuffer.append(buf, size);
   }
+
+  if (_resumeSession == nullptr)
+    return;
+
+  size_t end = _consoleBuffer.rfind('\n');
+  if (end == std::string::npos)
+    return;
+
+  std::string data = "O";
+  data += ToHex(_consoleBuffer.substr(0, end + 1));
+  _consoleBuffer.erase(0, end + 1);
+  _resumeSession->send(data);
 }
 
 ErrorCode DebugSessionImplBase::onSendInput(Session &session,
@@ -1383,10 +1498,20 @@ ErrorCode DebugSessionImplBase::fetchStopInfoForAllThreads(
     Session &session, std::vector<StopInfo> &stops, StopInfo &processStop) {
   CHK(onQueryThreadStopInfo(session, ProcessThreadId(), processStop));
 
+  //
+  // The thread list only matters for the process-wide stop, don't rebuild it
+  // for every thread. Only go back to the OS for the name and core of threads
+  // that stopped for a reason of their own, the others were merely held.
+  //
+  stops.reserve(processStop.threads.size());
   for (auto const &tid : processStop.threads) {
-    StopInfo stop;
-    onQueryThreadStopInfo(session, ProcessThreadId(kAnyProcessId, tid), stop);
-    stops.push_back(stop);
+    Thread *thread = _process->thread(tid);
+    if (thread == nullptr)
+      continue;
+
+    stops.emplace_back();
+    queryStopInfo(session, thread, stops.back(), false,
+                  thread->stopInfo().reason != StopInfo::kReasonNone);
   }
 
   return kSuccess;
@@ -46,9 +46,13 @@ ErrorCode DummySessionDelegateImpl::onToggleDebugFlag(Session &) {
   return kSuccess;
 }
 
-DUMMY_IMPL_EMPTY(onSetMaxPacketSize, Session &, size_t)
+ErrorCode DummySessionDelegateImpl::onSetMaxPacketSize(Session &, size_t) {
+  return kSuccess;
+}
 
-DUMMY_IMPL_EMPTY(onSetMaxPayloadSize, Session &, size_t)
+ErrorCode DummySessionDelegateImpl::onSetMaxPayloadSize(Session &, size_t) {
+  return kSuccess;
+}
 
 DUMMY_IMPL_EMPTY(onSetLogging, Session &, std::string const &,
                  std::string const &, StringCollection const &)
@@ -10,126 +10,139 @@
 
 #include "DebugServer2/GDBRemote/PacketProcessor.h"
 #include "DebugServer2/GDBRemote/ProtocolHelpers.h"
+#include "DebugServer2/Utils/HexValues.h"
 #include "DebugServer2/Utils/Log.h"
 
-#include <cstdlib>
-
 namespace ds2 {
 namespace GDBRemote {
 
 PacketProcessor::PacketProcessor()
-    : _nreqs(0), _needhash(false), _delegate(nullptr) {}
-
-bool PacketProcessor::validate() {
-  if (_buffer.empty())
-    return false;
-
-  if (_buffer[0] == '+' || _buffer[0] == '-' || _buffer[0] == '\x03')
-    return true;
-
-  size_t csoff = _buffer.find('#');
-  uint8_t csum =
-      static_cast<uint8_t>(std::strtoul(&_buffer[csoff + 1], nullptr, 16));
-
-  _buffer.erase(0, 1);
-  _buffer.erase(csoff - 1);
+    : _state(kStateIdle), _length(0), _maxPayloadSize(0), _checksum(0),
+      _expectedChecksum(0), _verifyChecksums(true), _delegate(nullptr) {}
 
-  uint8_t our_csum = Checksum(_buffer);
-
-  if (csum != our_csum)
-    DS2LOG(Warning,
-           "received packet %s with invalid checksum, should be %.2x, is %.2x",
-           _buffer.c_str(), our_csum, csum);
-
-  return csum == our_csum;
-}
-
-void PacketProcessor::process() {
-  _delegate->onPacketData(_buffer, validate());
-  _buffer.clear();
-  _nreqs = 0;
-}
-
-void PacketProcessor::parse(std::string const &data) {
-  size_t n = _nreqs;
+void PacketProcessor::parse(std::string_view data) {
+  static size_t const npos = std::string_view::npos;
 
   if (data.empty() || _delegate == nullptr)
     return;
 
   //
-  // Do we need to complete a packet?
+  // Offsets in `data` of the payload of the current packet, if it started
+  // in this read; otherwise its beginning is in _partial.
   //
-  if (n != 0 && data.length() != 0) {
-    _buffer += data.substr(0, n);
-    if (data.length() < _nreqs) {
-      _nreqs -= data.length();
-      if (_nreqs != 0)
-        return;
-    }
-
-    process();
-  }
+  size_t payload = npos;
+  size_t payloadEnd = npos;
+  size_t garbage = npos;
+  bool delivered = false;
 
-  //
-  // First will be std::string::npos if a packet
-  // has been processed.
-  //
-  size_t first = n;
+  size_t n = 0;
   while (n < data.size()) {
-    size_t end = std::string::npos;
-    if (_needhash) {
-      _needhash = false;
-      goto hash;
-    }
-
-    switch (data[n]) {
-    case '+':    // ACK
-    case '-':    // NAK
-    case '\x03': // Halt Target
-      end = n + 1;
+    switch (_state) {
+    case kStateIdle:
+      switch (data[n]) {
+      case '$':
+        _state = kStatePayload;
+        _checksum = 0;
+        _length = 0;
+        _partial.clear();
+        payload = ++n;
+        payloadEnd = npos;
+        break;
+
+      case '+':    // ACK
+      case '-':    // NAK
+      case '\x03': // Halt Target
+        _delegate->onPacketData(data.substr(n++, 1), true);
+        delivered = true;
+        break;
+
+      default:
+        if (garbage == npos) {
+          garbage = n;
+        }
+        n++;
+        break;
+      }
       break;
 
-    case '$':
-    hash:
-      end = data.find('#', n);
-      if (end++ != std::string::npos) {
-        size_t avail = data.length() - end;
-        if (avail < 2) {
-          _buffer += data.substr(n);
-          _nreqs = 2 - avail;
-          return;
-        } else {
-          end += 2;
-        }
+    case kStatePayload: {
+      size_t hash = data.find('#', n);
+      size_t end = (hash == npos) ? data.size() : hash;
+      std::string_view chunk = data.substr(n, end - n);
+
+      _length += chunk.size();
+      if (_verifyChecksums) {
+        _checksum += Checksum(chunk);
+      }
+      if (payload == npos && !overflow()) {
+        _partial.append(chunk);
+      }
+
+      n = end;
+      if (hash != npos) {
+        payloadEnd = hash;
+        _state = kStateChecksumHigh;
+        n++;
+      }
+    } break;
+
+    case kStateChecksumHigh: {
+      uint8_t nibble = HexToNibble(data[n++]);
+      _expectedChecksum = (nibble == kInvalidHexDigit) ? -1 : nibble << 4;
+      _state = kStateChecksumLow;
+    } break;
+
+    case kStateChecksumLow: {
+      uint8_t nibble = HexToNibble(data[n++]);
+      if (nibble == kInvalidHexDigit || _expectedChecksum < 0) {
+        _expectedChecksum = -1;
       } else {
-        _buffer += data.substr(n);
-        _needhash = true;
-        return;
+        _expectedChecksum |= nibble;
       }
-      break;
 
-    default:
-      n++;
-      continue;
-    }
+      std::string_view packet =
+          (payload != npos) ? data.substr(payload, payloadEnd - payload)
+                            : std::string_view(_partial);
+
+      bool valid = !_verifyChecksums || _expectedChecksum == _checksum;
+      if (overflow()) {
+        //
+        // Whatever the debugger sent past the size we advertised was not
+        // buffered, so the packet can't be handled. It is still acknowledged
+        // if it arrived intact, so that the debugger gets an error reply
+        // rather than retransmitting it forever.
+        //
+        DS2LOG(Warning, "received packet of %zu bytes, larger than %zu",
+               _length, _maxPayloadSize);
+        packet = kOversizedPacket;
+      } else if (!valid) {
+        DS2LOG(Warning,
+               "received packet %.*s with invalid checksum, should be %.2x, "
+               "is %.2x",
+               static_cast<int>(packet.size()), packet.data(), _checksum,
+               _expectedChecksum & 0xff);
+      }
 
-    if (end != std::string::npos) {
-      first = std::string::npos;
-      _buffer += data.substr(n, end - n);
-      process();
+      _delegate->onPacketData(packet, valid);
+      delivered = true;
+
+      _state = kStateIdle;
+      payload = npos;
+    } break;
     }
-    n = end;
   }
 
   //
-  // First is valid when there is data to add.
+  // The current packet continues in the next read, keep the part of it
+  // that we got in this one.
   //
-  if (first != std::string::npos && first < data.length()) {
-    if (_buffer.empty() && data[first] != '$') {
-      _delegate->onInvalidData(data.substr(first));
-      return;
-    }
-    _buffer += data.substr(first);
+  if (_state != kStateIdle && payload != npos && !overflow()) {
+    size_t end = (_state == kStatePayload) ? data.size() : payloadEnd;
+    _partial.assign(data.data() + payload, end - payload);
+  }
+
+  if (garbage != npos && !delivered) {
+    _delegate->onInvalidData(data.substr(garbage));
   }
 }
 } // namespace GDBRemote
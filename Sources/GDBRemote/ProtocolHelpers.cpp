@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/GDBRemote/ProtocolHelpers.h"
+#include "DebugServer2/Utils/Bits.h"
+
+#if defined(__SSE2__) || defined(_M_AMD64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_PROTOCOL_SSE2
+#include <emmintrin.h>
+#elif defined(ARCH_ARM64) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define HAVE_PROTOCOL_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ds2 {
+namespace GDBRemote {
+
+namespace {
+
+static size_t const kVectorSize = 16;
+
+inline bool IsEscapable(char c) {
+  return c == '$' || c == '#' || c == '}' || c == '*';
+}
+
+inline uint8_t ChecksumScalar(char const *data, size_t size) {
+  uint8_t csum = 0;
+  for (size_t n = 0; n < size; n++) {
+    csum += data[n];
+  }
+  return csum;
+}
+
+size_t FindScalar(char const *data, size_t offset, size_t size, bool runs) {
+  for (; offset < size; offset++) {
+    if (IsEscapable(data[offset]))
+      break;
+    if (runs && offset + 1 < size && data[offset] == data[offset + 1])
+      break;
+  }
+  return offset;
+}
+
+#if defined(HAVE_PROTOCOL_SSE2)
+inline __m128i EscapableMask(__m128i v) {
+  __m128i m = _mm_cmpeq_epi8(v, _mm_set1_epi8('$'));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('#')));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('*')));
+  return m;
+}
+#elif defined(HAVE_PROTOCOL_NEON)
+inline uint8x16_t EscapableMask(uint8x16_t v) {
+  uint8x16_t m = vceqq_u8(v, vdupq_n_u8('$'));
+  m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('#')));
+  m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('}')));
+  m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('*')));
+  return m;
+}
+#endif
+} // namespace
+
+uint8_t Checksum(std::string_view data) {
+  char const *p = data.data();
+  size_t size = data.size();
+  size_t n = 0;
+
+  //
+  // The checksum is the byte sum modulo 256, so bytes can be accumulated
+  // lane-wise with wrapping adds and the lanes summed at the end.
+  //
+#if defined(HAVE_PROTOCOL_SSE2)
+  if (size >= kVectorSize) {
+    __m128i acc = _mm_setzero_si128();
+    for (; n + kVectorSize <= size; n += kVectorSize) {
+      acc = _mm_add_epi8(
+          acc, _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + n)));
+    }
+    __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+    uint8_t csum = static_cast<uint8_t>(
+        _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    return csum + ChecksumScalar(p + n, size - n);
+  }
+#elif defined(HAVE_PROTOCOL_NEON)
+  if (size >= kVectorSize) {
+    uint8x16_t acc = vdupq_n_u8(0);
+    for (; n + kVectorSize <= size; n += kVectorSize) {
+      acc = vaddq_u8(acc, vld1q_u8(reinterpret_cast<uint8_t const *>(p + n)));
+    }
+    uint8_t csum = static_cast<uint8_t>(vaddlvq_u8(acc));
+    return csum + ChecksumScalar(p + n, size - n);
+  }
+#endif
+
+  return ChecksumScalar(p, size);
+}
+
+size_t FindEscapableOrRun(std::string_view data, size_t offset, bool runs) {
+  char const *p = data.data();
+  size_t size = data.size();
+
+  //
+  // Skip over whole vectors with nothing to escape. When looking for runs,
+  // each vector is also compared with itself shifted by one byte, which
+  // needs one byte past its end.
+  //
+  size_t lookahead = runs ? 1 : 0;
+
+#if defined(HAVE_PROTOCOL_SSE2)
+  while (offset + kVectorSize + lookahead <= size) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + offset));
+    __m128i m = EscapableMask(v);
+    if (runs) {
+      __m128i next =
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + offset + 1));
+      m = _mm_or_si128(m, _mm_cmpeq_epi8(v, next));
+    }
+    unsigned int mask = _mm_movemask_epi8(m);
+    if (mask != 0)
+      return offset + Utils::FFS(mask) - 1;
+    offset += kVectorSize;
+  }
+#elif defined(HAVE_PROTOCOL_NEON)
+  while (offset + kVectorSize + lookahead <= size) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<uint8_t const *>(p + offset));
+    uint8x16_t m = EscapableMask(v);
+    if (runs) {
+      uint8x16_t next =
+          vld1q_u8(reinterpret_cast<uint8_t const *>(p + offset + 1));
+      m = vorrq_u8(m, vceqq_u8(v, next));
+    }
+    if (vmaxvq_u8(m) != 0)
+      break;
+    offset += kVectorSize;
+  }
+#endif
+
+  return FindScalar(p, offset, size, runs);
+}
+
+size_t FindEscapable(std::string_view data, size_t offset) {
+  return FindEscapableOrRun(data, offset, false);
+}
+
+size_t EscapedPrefixLength(std::string_view data, size_t budget) {
+  size_t used = 0;
+
+  size_t first = 0;
+  while (first < data.size()) {
+    size_t last = FindEscapable(data, first);
+    if (used + (last - first) > budget)
+      return first + (budget - used);
+
+    used += last - first;
+    if (last == data.size() || used + 2 > budget)
+      return last;
+
+    used += 2;
+    first = last + 1;
+  }
+
+  return first;
+}
+
+void Escape(std::string_view data, std::string &out) {
+  out.reserve(out.size() + data.size());
+
+  size_t first = 0;
+  while (first < data.size()) {
+    size_t last = FindEscapable(data, first);
+    out.append(data.data() + first, last - first);
+    if (last == data.size())
+      break;
+
+    out += '}';
+    out += static_cast<char>(data[last] ^ 0x20);
+    first = last + 1;
+  }
+}
+
+void Unescape(std::string_view data, std::string &out) {
+  out.reserve(out.size() + data.size());
+
+  size_t first = 0;
+  while (first < data.size()) {
+    size_t last = data.find('}', first);
+    if (last == std::string_view::npos || last + 1 == data.size()) {
+      out.append(data.data() + first, data.size() - first);
+      break;
+    }
+
+    out.append(data.data() + first, last - first);
+    out += static_cast<char>(data[last + 1] ^ 0x20);
+    first = last + 2;
+  }
+}
+} // namespace GDBRemote
+} // namespace ds2
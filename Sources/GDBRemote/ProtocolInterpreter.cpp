@@ -25,7 +25,7 @@ namespace GDBRemote {
 
 namespace {
 
-std::string EscapeForTerm(std::string const &s) {
+std::string EscapeForTerm(std::string_view s) {
   std::ostringstream ss;
   for (char n : s) {
     unsigned c = static_cast<unsigned>(n & 0xff);
@@ -41,7 +41,7 @@ std::string EscapeForTerm(std::string const &s) {
 
 using CommandRange = std::pair<size_t, size_t>;
 
-CommandRange splitCommand(const std::string &data) {
+CommandRange splitCommand(std::string_view data) {
   CommandRange range = {std::string::npos, std::string::npos};
 
   if (data.empty())
@@ -103,10 +103,11 @@ CommandRange splitCommand(const std::string &data) {
 
 } // namespace
 
-ProtocolInterpreter::ProtocolInterpreter() : _session(nullptr) {}
+ProtocolInterpreter::ProtocolInterpreter()
+    : _session(nullptr), _argumentsInUse(false) {}
 
-void ProtocolInterpreter::onPacketData(std::string const &data, bool valid) {
-  DS2LOG(Packet, "getpkt(\"%s\")", EscapeForTerm(&data[0]).c_str());
+void ProtocolInterpreter::onPacketData(std::string_view data, bool valid) {
+  DS2LOG(Packet, "getpkt(\"%s\")", EscapeForTerm(data).c_str());
 
   if (_session == nullptr)
     return;
@@ -137,6 +138,12 @@ void ProtocolInterpreter::onPacketData(std::string const &data, bool valid) {
   if (!_session->onCommandReceived(valid) || !valid)
     return;
 
+  if (data == PacketProcessor::kOversizedPacket) {
+    _session->sendError(kErrorInvalidArgument);
+    _session->flush();
+    return;
+  }
+
   //
   // Extract the command and arguments to pass down to the
   // handler.
@@ -153,10 +160,12 @@ void ProtocolInterpreter::onPacketData(std::string const &data, bool valid) {
   // Find the handler and execute it.
   //
   onCommand(command, args);
+  _session->flush();
 }
 
-void ProtocolInterpreter::onInvalidData(std::string const &data) {
-  DS2LOG(Warning, "received invalid data: '%s'", data.c_str());
+void ProtocolInterpreter::onInvalidData(std::string_view data) {
+  DS2LOG(Warning, "received invalid data: '%.*s'",
+         static_cast<int>(data.size()), data.data());
 
   if (_session == nullptr)
     return;
@@ -179,22 +188,39 @@ void ProtocolInterpreter::onCommand(std::string_view command,
     return;
   }
 
-  std::string extra;
+  //
+  // Handlers parse their arguments with C library functions that need them
+  // NUL-terminated, assemble them in a buffer that is reused across packets.
+  //
+  std::string localArguments, localUnescaped;
+  bool reuse = !_argumentsInUse.exchange(true);
+  std::string &extra = reuse ? _arguments : localArguments;
+  std::string &unescaped = reuse ? _unescapedArguments : localUnescaped;
+
+  extra.clear();
   if (commandLength != command.length()) {
     //
     // Command has part of the argument, LLDB doesn't use separators :(
     //
-    extra.assign(command.data() + commandLength, command.length() - commandLength);
+    extra.append(command.data() + commandLength,
+                 command.length() - commandLength);
   }
 
   extra.append(arguments.data(), arguments.length());
 
   if (extra.find_first_of("*}") != std::string::npos) {
-    extra = Unescape(extra);
-    DS2LOG(Packet, "args='%.*s'", static_cast<int>(extra.length()), &extra[0]);
+    unescaped.clear();
+    Unescape(extra, unescaped);
+    extra.swap(unescaped);
+    DS2LOG(Packet, "args='%.*s'", static_cast<int>(extra.length()),
+           extra.data());
   }
 
   (handler->handler->*handler->callback)(*handler, extra);
+
+  if (reuse) {
+    _argumentsInUse.store(false);
+  }
 }
 
 bool ProtocolInterpreter::registerHandler(Handler const &handler) {
@@ -212,26 +238,41 @@ bool ProtocolInterpreter::registerHandler(Handler const &handler) {
     return false;
 
   _handlers.insert(it, handler);
+  indexHandlers();
 
   return true;
 }
 
+void ProtocolInterpreter::indexHandlers() {
+  _exactHandlers.clear();
+  _prefixHandlers.clear();
+
+  for (Handler const &handler : _handlers) {
+    if (handler.mode == Handler::kModeEquals) {
+      _exactHandlers.emplace(handler.command, &handler);
+    } else {
+      _prefixHandlers.push_back(&handler);
+    }
+  }
+}
+
 ProtocolInterpreter::Handler const *
 ProtocolInterpreter::findHandler(std::string_view command,
                                  size_t &commandLength) const {
-  auto it = std::lower_bound(
-      _handlers.begin(), _handlers.end(), command,
-      [](Handler const &handler, std::string_view command) -> bool {
-        return handler.compare(command) < 0;
-      });
+  auto it = _exactHandlers.find(command);
+  if (it != _exactHandlers.end()) {
+    commandLength = command.length();
+    return it->second;
+  }
 
-  Handler const *handler = nullptr;
-  if (it != _handlers.end() && it->compare(command) == 0) {
-    commandLength = it->command.length();
-    handler = &(*it);
+  for (Handler const *handler : _prefixHandlers) {
+    if (handler->compare(command) == 0) {
+      commandLength = handler->command.length();
+      return handler;
+    }
   }
 
-  return handler;
+  return nullptr;
 }
 
 int ProtocolInterpreter::Handler::compare(std::string_view command_) const {
@@ -16,6 +16,7 @@
 #include "DebugServer2/Utils/String.h"
 #include "DebugServer2/Utils/SwapEndian.h"
 
+#include <charconv>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
@@ -90,6 +91,7 @@ Session::Session(CompatibilityMode mode)
   REGISTER_HANDLER_EQUALS_1(QAgent);
   REGISTER_HANDLER_EQUALS_1(QAllow);
   REGISTER_HANDLER_EQUALS_1(QDisableRandomization);
+  REGISTER_HANDLER_EQUALS_1(QEnableCompression);
   REGISTER_HANDLER_EQUALS_1(QEnvironment);
   REGISTER_HANDLER_EQUALS_1(QEnvironmentHexEncoded);
   REGISTER_HANDLER_EQUALS_1(QLaunchArch);
@@ -209,6 +211,22 @@ bool Session::ParseList(std::string const &string, char separator,
   return true;
 }
 
+bool Session::decodeHexArgument(std::string_view hex, std::string &result) {
+  if (!HexToString(hex, result)) {
+    sendError(kErrorInvalidArgument);
+    return false;
+  }
+  return true;
+}
+
+bool Session::decodeHexArgument(std::string_view hex, ByteVector &result) {
+  if (!HexToByteVector(hex, result)) {
+    sendError(kErrorInvalidArgument);
+    return false;
+  }
+  return true;
+}
+
 //
 // Parses and formats the brain-dead idea of hex values
 // in native-endian format used by GDB remote protocol
@@ -257,6 +275,39 @@ std::string Session::formatAddress(Address const &address,
   return ss.str();
 }
 
+// Sends as many of the threads left in the list as fit in a reply, as a
+// comma separated list.
+void Session::sendThreadList() {
+  if (_threadList.next == _threadList.tids.size()) {
+    send("l");
+    return;
+  }
+
+  size_t budget = getMaxReplyPayloadSize();
+  std::string &reply = _threadList.reply;
+  reply.assign("m");
+  reply += getPacketSeparator();
+
+  size_t first = _threadList.next;
+  for (; _threadList.next < _threadList.tids.size(); _threadList.next++) {
+    char digits[2 * sizeof(ThreadId)];
+    auto tid = static_cast<std::make_unsigned_t<ThreadId>>(
+        _threadList.tids[_threadList.next]);
+    char *end = std::to_chars(digits, digits + sizeof(digits), tid, 16).ptr;
+
+    bool separator = (_threadList.next != first);
+    if (separator && reply.size() + 1 + (end - digits) > budget)
+      break;
+
+    if (separator) {
+      reply += ',';
+    }
+    reply.append(digits, end);
+  }
+
+  send(reply);
+}
+
 // Map the flags specified by the lldb server protocl for vFile:open: to
 // internal flags used by the session delegate.
 //
@@ -373,10 +424,12 @@ void Session::Handle_A(ProtocolInterpreter::Handler const &,
       return;
     }
 
-    std::string &s = argmap[argno];
-    for (size_t n = 0; n < nchars; n += 2) {
-      s += static_cast<char>(HexToByte(eptr + n));
+    if (static_cast<size_t>(end - eptr) < nchars) {
+      sendError(kErrorInvalidArgument);
+      return;
     }
+    if (!decodeHexArgument(std::string_view(eptr, nchars), argmap[argno]))
+      return;
     eptr += nchars;
   }
 
@@ -777,7 +830,9 @@ void Session::Handle_H(ProtocolInterpreter::Handler const &,
 void Session::Handle_I(ProtocolInterpreter::Handler const &,
                        std::string const &args) {
   if (_compatMode == kCompatibilityModeLLDB) {
-    ByteVector data(HexToByteVector(args.data()));
+    ByteVector data;
+    if (!decodeHexArgument(args, data))
+      return;
     CHK_SEND(_delegate->onSendInput(*this, data));
 
     sendOK();
@@ -981,7 +1036,9 @@ void Session::Handle_M(ProtocolInterpreter::Handler const &,
     return;
   }
 
-  ByteVector data(HexToByteVector(eptr));
+  ByteVector data;
+  if (!decodeHexArgument(eptr, data))
+    return;
   if (data.size() > length) {
     data.resize(length);
   }
@@ -1009,6 +1066,12 @@ void Session::Handle_m(ProtocolInterpreter::Handler const &,
   }
   length = strtoull(eptr, nullptr, 16);
 
+  //
+  // Each byte takes two hex digits. Reading less than what was asked for is
+  // allowed, the debugger asks again for the rest.
+  //
+  length = std::min<uint64_t>(length, getMaxReplyPayloadSize() / 2);
+
   CHK_SEND(_delegate->onReadMemory(*this, address, length, data));
 
   send(ToHex(data));
@@ -1039,7 +1102,8 @@ void Session::Handle_P(ProtocolInterpreter::Handler const &,
     ptidptr = std::strchr(eptr, '\0');
   }
 
-  value = HexToString(std::string(eptr, ptidptr - eptr));
+  if (!decodeHexArgument(std::string_view(eptr, ptidptr - eptr), value))
+    return;
 
   if (*ptidptr == ';') {
     //
@@ -1108,6 +1172,42 @@ void Session::Handle_p(ProtocolInterpreter::Handler const &,
   send(ToHex(value));
 }
 
+//
+// Packet:        QEnableCompression:type:<type>;[minsize:<size>;]
+// Description:   Compress every packet sent after the reply to this one
+//                with the given algorithm, as long as its payload is
+//                larger than minsize bytes.
+// Compatibility: LLDB
+//
+void Session::Handle_QEnableCompression(ProtocolInterpreter::Handler const &,
+                                        std::string const &args) {
+  bool haveType = false;
+  CompressionType type = kCompressionTypeNone;
+  size_t minSize = kDefaultCompressionMinSize;
+
+  ParseList(args, ';', [&](std::string const &arg) {
+    size_t colon = arg.find(':');
+    if (colon == std::string::npos)
+      return;
+
+    std::string key = arg.substr(0, colon);
+    std::string value = arg.substr(colon + 1);
+    if (key == "type") {
+      haveType = ParseCompressionType(value, type);
+    } else if (key == "minsize") {
+      minSize = std::strtoull(value.c_str(), nullptr, 10);
+    }
+  });
+
+  if (!haveType) {
+    sendError(kErrorInvalidArgument);
+    return;
+  }
+
+  sendOK();
+  setCompression(type, minSize);
+}
+
 //
 // Packet:        QEnvironment:name=value
 // Description:   Sets the environment variable to the value specified
@@ -1133,7 +1233,9 @@ void Session::Handle_QEnvironment(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_QEnvironmentHexEncoded(
     ProtocolInterpreter::Handler const &, std::string const &args) {
-  std::string key, value, ev(HexToString(args));
+  std::string key, value, ev;
+  if (!decodeHexArgument(args, ev))
+    return;
 
   size_t eq = ev.find('=');
   if (eq != std::string::npos) {
@@ -1323,12 +1425,15 @@ void Session::Handle_QDisableRandomization(ProtocolInterpreter::Handler const &,
 void Session::Handle_QSetMaxPacketSize(ProtocolInterpreter::Handler const &,
                                        std::string const &args) {
   uint32_t size = std::strtoul(args.c_str(), nullptr, 16);
-  if (size == 0) {
+  if (size < kMinPacketSize) {
     sendError(kErrorInvalidArgument);
     return;
   }
 
-  sendError(_delegate->onSetMaxPacketSize(*this, size));
+  CHK_SEND(_delegate->onSetMaxPacketSize(*this, size));
+
+  setMaxReplySize(size);
+  sendOK();
 }
 
 //
@@ -1340,12 +1445,15 @@ void Session::Handle_QSetMaxPacketSize(ProtocolInterpreter::Handler const &,
 void Session::Handle_QSetMaxPayloadSize(ProtocolInterpreter::Handler const &,
                                         std::string const &args) {
   uint32_t size = std::strtoul(args.c_str(), nullptr, 16);
-  if (size == 0) {
+  if (size + kPacketFramingSize < kMinPacketSize) {
     sendError(kErrorInvalidArgument);
     return;
   }
 
-  sendError(_delegate->onSetMaxPayloadSize(*this, size));
+  CHK_SEND(_delegate->onSetMaxPayloadSize(*this, size));
+
+  setMaxReplySize(size + kPacketFramingSize);
+  sendOK();
 }
 
 //
@@ -1355,7 +1463,11 @@ void Session::Handle_QSetMaxPayloadSize(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_QSetSTDERR(ProtocolInterpreter::Handler const &,
                                 std::string const &args) {
-  sendError(_delegate->onSetStdFile(*this, 2, HexToString(args)));
+  std::string path;
+  if (!decodeHexArgument(args, path))
+    return;
+
+  sendError(_delegate->onSetStdFile(*this, 2, path));
 }
 
 //
@@ -1365,7 +1477,11 @@ void Session::Handle_QSetSTDERR(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_QSetSTDIN(ProtocolInterpreter::Handler const &,
                                std::string const &args) {
-  sendError(_delegate->onSetStdFile(*this, 0, HexToString(args)));
+  std::string path;
+  if (!decodeHexArgument(args, path))
+    return;
+
+  sendError(_delegate->onSetStdFile(*this, 0, path));
 }
 
 //
@@ -1375,7 +1491,11 @@ void Session::Handle_QSetSTDIN(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_QSetSTDOUT(ProtocolInterpreter::Handler const &,
                                 std::string const &args) {
-  sendError(_delegate->onSetStdFile(*this, 1, HexToString(args)));
+  std::string path;
+  if (!decodeHexArgument(args, path))
+    return;
+
+  sendError(_delegate->onSetStdFile(*this, 1, path));
 }
 
 //
@@ -1385,7 +1505,11 @@ void Session::Handle_QSetSTDOUT(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_QSetWorkingDir(ProtocolInterpreter::Handler const &,
                                     std::string const &args) {
-  sendError(_delegate->onSetWorkingDirectory(*this, HexToString(args)));
+  std::string path;
+  if (!decodeHexArgument(args, path))
+    return;
+
+  sendError(_delegate->onSetWorkingDirectory(*this, path));
 }
 
 //
@@ -1581,9 +1705,12 @@ void Session::Handle_qFileLoadAddress(ProtocolInterpreter::Handler const &,
     return;
   }
 
+  std::string path;
+  if (!decodeHexArgument(args, path))
+    return;
+
   Address address;
-  CHK_SEND(
-      _delegate->onQueryFileLoadAddress(*this, HexToString(args), address));
+  CHK_SEND(_delegate->onQueryFileLoadAddress(*this, path, address));
 
   send(formatAddress(address, kEndianBig));
 }
@@ -1861,8 +1988,11 @@ void Session::Handle_qMemoryRegionInfo(ProtocolInterpreter::Handler const &,
 void Session::Handle_qModuleInfo(ProtocolInterpreter::Handler const &,
                                  std::string const &args) {
   size_t semicolon = args.find(';');
-  std::string path(HexToString(args.substr(0, semicolon)));
-  std::string triple(HexToString(args.substr(semicolon + 1)));
+  std::string path, triple;
+  if (!decodeHexArgument(std::string_view(args).substr(0, semicolon), path) ||
+      !decodeHexArgument(std::string_view(args).substr(semicolon + 1), triple))
+    return;
+
   ModuleInfo info;
 
   CHK_SEND(_delegate->onQueryModuleInfo(*this, path, triple, info));
@@ -1944,8 +2074,11 @@ void Session::Handle_qPlatform_chmod(ProtocolInterpreter::Handler const &,
     return;
   }
 
-  ErrorCode error =
-      _delegate->onFileSetPermissions(*this, HexToString(eptr), mode);
+  std::string path;
+  if (!decodeHexArgument(eptr, path))
+    return;
+
+  ErrorCode error = _delegate->onFileSetPermissions(*this, path, mode);
   if (error != kSuccess) {
     sendError(error);
     return;
@@ -1969,7 +2102,11 @@ void Session::Handle_qPlatform_mkdir(ProtocolInterpreter::Handler const &,
     return;
   }
 
-  CHK_SEND(_delegate->onFileCreateDirectory(*this, HexToString(eptr), mode));
+  std::string path;
+  if (!decodeHexArgument(eptr, path))
+    return;
+
+  CHK_SEND(_delegate->onFileCreateDirectory(*this, path, mode));
 
   // Send F + <return code>, which is always 0 on success
   send("F0");
@@ -1984,14 +2121,14 @@ void Session::Handle_qPlatform_mkdir(ProtocolInterpreter::Handler const &,
 void Session::Handle_qPlatform_shell(ProtocolInterpreter::Handler const &,
                                      std::string const &args) {
   size_t comma = args.find(',');
-  std::string workingDir;
-  std::string command(HexToString(args.substr(0, comma)));
+  std::string command, workingDir;
+  if (!decodeHexArgument(std::string_view(args).substr(0, comma), command))
+    return;
 
   char *eptr;
   uint32_t timeout = std::strtoul(&args[comma + 1], &eptr, 16);
-  if (*eptr++ == ',') {
-    workingDir = HexToString(eptr);
-  }
+  if (*eptr++ == ',' && !decodeHexArgument(eptr, workingDir))
+    return;
 
   ProgramResult result;
   ErrorCode error =
@@ -2048,7 +2185,9 @@ void Session::Handle_qProcessInfoPID(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_qRcmd(ProtocolInterpreter::Handler const &,
                            std::string const &args) {
-  std::string cmd = HexToString(args);
+  std::string cmd;
+  if (!decodeHexArgument(args, cmd))
+    return;
 
   // Special-case the exit command, since the handler will not
   // return from an exit, and we need to send an OK packet.
@@ -2100,9 +2239,13 @@ void Session::Handle_qSearch(ProtocolInterpreter::Handler const &,
     return;
   }
 
+  std::string pattern;
+  if (!decodeHexArgument(eptr, pattern))
+    return;
+
   Address location;
   ErrorCode error = _delegate->onSearch(
-      *this, address, std::string(HexToString(eptr), length), location);
+      *this, address, std::string(pattern, length), location);
   if (error != kSuccess && error != kErrorNotFound) {
     sendError(error);
     return;
@@ -2255,6 +2398,12 @@ void Session::Handle_qSupported(ProtocolInterpreter::Handler const &,
   }
 
   send(result);
+
+  //
+  // Both GDB and LLDB expand run-length encoded replies; a client that
+  // negotiated features is past the handshake and can receive them.
+  //
+  setRunLengthEncoding(true);
 }
 
 //
@@ -2290,10 +2439,9 @@ void Session::Handle_qSymbol(ProtocolInterpreter::Handler const &,
 
   std::string name, value;
 
-  value = HexToString(args.substr(0, name_begin));
-  if (++name_begin < args.size()) {
-    name = HexToString(args.substr(name_begin));
-  }
+  if (!decodeHexArgument(std::string_view(args).substr(0, name_begin), value) ||
+      !decodeHexArgument(std::string_view(args).substr(name_begin + 1), name))
+    return;
 
   // This is a query packet.
   if (value.empty() && name.empty()) {
@@ -2491,9 +2639,22 @@ void Session::Handle_qXfer(ProtocolInterpreter::Handler const &,
     bool last = true;
     std::string buffer;
 
+    //
+    // One byte of the reply goes to the m or l prefix. Documents that don't
+    // fit are sent in chunks, the debugger keeps reading while it gets m.
+    //
+    size_t budget = getMaxReplyPayloadSize() - 1;
+    length = std::min<uint64_t>(length, budget);
+
     CHK_SEND(_delegate->onXferRead(*this, object, annex, offset, length, buffer,
                                    last));
 
+    size_t fits = EscapedPrefixLength(buffer, budget);
+    if (fits < buffer.size()) {
+      buffer.resize(fits);
+      last = false;
+    }
+
     send((last || buffer.empty() ? "l" : "m") + buffer);
   } else {
     sendError(kErrorInvalidArgument);
@@ -2509,6 +2670,7 @@ void Session::Handle_qXfer(ProtocolInterpreter::Handler const &,
 void Session::Handle_qfProcessInfo(ProtocolInterpreter::Handler const &,
                                    std::string const &args) {
   ProcessInfoMatch match;
+  bool valid = true;
 
   ParseList(args, ';', [&](std::string const &arg) {
     std::string key, value;
@@ -2520,7 +2682,7 @@ void Session::Handle_qfProcessInfo(ProtocolInterpreter::Handler const &,
     value = arg.substr(colon + 1);
 
     if (key == "name") {
-      match.name = HexToString(value);
+      valid = HexToString(value, match.name) && valid;
     } else if (key == "name_match") {
       match.nameMatch = value;
     } else if (key == "pid") {
@@ -2546,6 +2708,11 @@ void Session::Handle_qfProcessInfo(ProtocolInterpreter::Handler const &,
     match.keys.push_back(key);
   });
 
+  if (!valid) {
+    sendError(kErrorInvalidArgument);
+    return;
+  }
+
   ProcessInfo info;
   CHK_SEND(_delegate->onQueryProcessList(*this, match, true, info));
 
@@ -2573,21 +2740,24 @@ void Session::Handle_qsProcessInfo(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_qfThreadInfo(ProtocolInterpreter::Handler const &,
                                   std::string const &) {
-  ThreadId tid;
-  ErrorCode error =
-      _delegate->onQueryThreadList(*this, kAnyProcessId, kAllThreadId, tid);
-  if (error != kSuccess && error != kErrorNotFound) {
-    sendError(error);
-    return;
+  _threadList.tids.clear();
+  _threadList.next = 0;
+
+  for (;;) {
+    ThreadId tid;
+    ErrorCode error = _delegate->onQueryThreadList(
+        *this, kAnyProcessId,
+        _threadList.tids.empty() ? kAllThreadId : kAnyThreadId, tid);
+    if (error == kErrorNotFound)
+      break;
+    if (error != kSuccess) {
+      sendError(error);
+      return;
+    }
+    _threadList.tids.push_back(tid);
   }
 
-  if (error == kErrorNotFound) {
-    send("l");
-  } else {
-    std::ostringstream ss;
-    ss << "m" << getPacketSeparator() << std::hex << tid;
-    send(ss.str());
-  }
+  sendThreadList();
 }
 
 //
@@ -2597,21 +2767,7 @@ void Session::Handle_qfThreadInfo(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_qsThreadInfo(ProtocolInterpreter::Handler const &,
                                   std::string const &) {
-  ThreadId tid;
-  ErrorCode error =
-      _delegate->onQueryThreadList(*this, kAnyProcessId, kAnyThreadId, tid);
-  if (error != kSuccess && error != kErrorNotFound) {
-    sendError(error);
-    return;
-  }
-
-  if (error == kErrorNotFound) {
-    send("l");
-  } else {
-    std::ostringstream ss;
-    ss << "m" << getPacketSeparator() << std::hex << tid;
-    send(ss.str());
-  }
+  sendThreadList();
 }
 
 //
@@ -2819,8 +2975,12 @@ void Session::Handle_vAttach(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_vAttachName(ProtocolInterpreter::Handler const &,
                                  std::string const &args) {
+  std::string name;
+  if (!decodeHexArgument(args, name))
+    return;
+
   StopInfo stop;
-  CHK_SEND(_delegate->onAttach(*this, HexToString(args), kAttachNow, stop));
+  CHK_SEND(_delegate->onAttach(*this, name, kAttachNow, stop));
 
   send(stop.encode(_compatMode, _threadsInStopReply));
 
@@ -2840,8 +3000,12 @@ void Session::Handle_vAttachName(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_vAttachOrWait(ProtocolInterpreter::Handler const &,
                                    std::string const &args) {
+  std::string name;
+  if (!decodeHexArgument(args, name))
+    return;
+
   StopInfo stop;
-  CHK_SEND(_delegate->onAttach(*this, HexToString(args), kAttachOrWait, stop));
+  CHK_SEND(_delegate->onAttach(*this, name, kAttachOrWait, stop));
 
   send(stop.encode(_compatMode, _threadsInStopReply));
 
@@ -2860,8 +3024,12 @@ void Session::Handle_vAttachOrWait(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_vAttachWait(ProtocolInterpreter::Handler const &,
                                  std::string const &args) {
+  std::string name;
+  if (!decodeHexArgument(args, name))
+    return;
+
   StopInfo stop;
-  CHK_SEND(_delegate->onAttach(*this, HexToString(args), kAttachAndWait, stop));
+  CHK_SEND(_delegate->onAttach(*this, name, kAttachAndWait, stop));
 
   send(stop.encode(_compatMode, _threadsInStopReply));
 
@@ -2971,6 +3139,13 @@ void Session::Handle_vFile(ProtocolInterpreter::Handler const &,
   std::string op = args.substr(op_start, op_end);
   op_end++;
 
+  std::string path;
+  if (op == "unlink" || op == "readlink" || op == "exists" || op == "MD5" ||
+      op == "size" || op == "mode") {
+    if (!decodeHexArgument(std::string_view(args).substr(op_end), path))
+      return;
+  }
+
   //
   // GDB:  vFile:open:path,flags,mode
   //       vFile:close:fd
@@ -3007,10 +3182,12 @@ void Session::Handle_vFile(ProtocolInterpreter::Handler const &,
 
     uint32_t mode = std::strtoul(eptr, nullptr, 16);
 
+    if (!decodeHexArgument(
+            std::string_view(args).substr(op_end, comma - op_end), path))
+      return;
+
     int fd;
-    ErrorCode error = _delegate->onFileOpen(
-        *this, HexToString(args.substr(op_end, comma - op_end)), openFlags,
-        mode, fd);
+    ErrorCode error = _delegate->onFileOpen(*this, path, openFlags, mode, fd);
     if (error != kSuccess) {
       ss << 'F' << -1 << ',' << std::hex << error;
     } else {
@@ -3038,11 +3215,23 @@ void Session::Handle_vFile(ProtocolInterpreter::Handler const &,
     }
     uint64_t offset = strtoull(eptr, &eptr, 16);
 
+    //
+    // Leave room for the F<count>; header, the data is escaped and cut to
+    // what fits once it has been read.
+    //
+    size_t budget = getMaxReplyPayloadSize() - (sizeof("F;") + 16);
+    count = std::min<uint64_t>(count, budget);
+
     ByteVector buffer;
     ErrorCode error = _delegate->onFileRead(*this, fd, count, offset, buffer);
     if (error != kSuccess) {
       ss << 'F' << -1 << ',' << std::hex << error;
     } else {
+      buffer.resize(EscapedPrefixLength(
+          std::string_view(reinterpret_cast<char const *>(buffer.data()),
+                           buffer.size()),
+          budget));
+      count = buffer.size();
       ss << 'F' << std::hex << count << ';' << Escape(buffer);
       escaped = true;
     }
@@ -3073,8 +3262,7 @@ void Session::Handle_vFile(ProtocolInterpreter::Handler const &,
       ss << 'F' << std::hex << length;
     }
   } else if (op == "unlink") {
-    ErrorCode error =
-        _delegate->onFileRemove(*this, HexToString(&args[op_end]));
+    ErrorCode error = _delegate->onFileRemove(*this, path);
     if (error != kSuccess) {
       ss << 'F' << -1 << ',' << std::hex << error;
     } else {
@@ -3082,22 +3270,19 @@ void Session::Handle_vFile(ProtocolInterpreter::Handler const &,
     }
   } else if (op == "readlink") {
     std::string resolved;
-    ErrorCode error =
-        _delegate->onFileReadLink(*this, HexToString(&args[op_end]), resolved);
+    ErrorCode error = _delegate->onFileReadLink(*this, path, resolved);
     if (error != kSuccess) {
       ss << 'F' << -1 << ',' << std::hex << error;
     } else {
       ss << 'F' << 0 << ';' << ToHex(resolved);
     }
   } else if (op == "exists") {
-    ErrorCode error =
-        _delegate->onFileExists(*this, HexToString(&args[op_end]));
+    ErrorCode error = _delegate->onFileExists(*this, path);
     // F,<bool>
     ss << 'F' << ',' << (error != kSuccess ? 0 : 1);
   } else if (op == "MD5") {
     uint8_t digest[16];
-    ErrorCode error =
-        _delegate->onFileComputeMD5(*this, HexToString(&args[op_end]), digest);
+    ErrorCode error = _delegate->onFileComputeMD5(*this, path, digest);
     ss << 'F' << ',';
     // F,<value> or F,x if not found
     if (error != kSuccess) {
@@ -3109,8 +3294,7 @@ void Session::Handle_vFile(ProtocolInterpreter::Handler const &,
     }
   } else if (op == "size") {
     uint64_t size;
-    ErrorCode error =
-        _delegate->onFileGetSize(*this, HexToString(&args[op_end]), size);
+    ErrorCode error = _delegate->onFileGetSize(*this, path, size);
     // Response is F followed by the file size in base 16 or
     // F-1,errno with the errno if an error occurs, base 16.
     ss << 'F';
@@ -3121,8 +3305,7 @@ void Session::Handle_vFile(ProtocolInterpreter::Handler const &,
     }
   } else if (op == "mode") {
     uint32_t mode;
-    ErrorCode error =
-        _delegate->onFileGetMode(*this, HexToString(&args[op_end]), mode);
+    ErrorCode error = _delegate->onFileGetMode(*this, path, mode);
     // Response is F followed by the mode bits in base 16 or
     // F-1,errno with the errno if an error occurs, base 16
     ss << 'F';
@@ -3248,15 +3431,23 @@ void Session::Handle_vRun(ProtocolInterpreter::Handler const &,
   std::string filename;
   StringCollection arguments;
   size_t index = 0;
+  bool valid = true;
 
   ParseList(args, ';', [&](std::string const &arg) {
+    std::string value;
+    valid = HexToString(arg, value) && valid;
     if (index++ == 0) {
-      filename = HexToString(arg);
+      filename = std::move(value);
     } else {
-      arguments.push_back(HexToString(arg));
+      arguments.push_back(std::move(value));
     }
   });
 
+  if (!valid) {
+    sendError(kErrorInvalidArgument);
+    return;
+  }
+
   StopInfo stop;
   CHK_SEND(_delegate->onRunAttach(*this, filename, arguments, stop));
 
@@ -3355,8 +3546,19 @@ void Session::Handle_x(ProtocolInterpreter::Handler const &,
     return;
   }
 
+  //
+  // Binary data is escaped, so what fits in a reply depends on the contents;
+  // read as much as could fit and cut what doesn't once escaped.
+  //
+  length = std::min<uint64_t>(length, getMaxReplyPayloadSize());
+
   CHK_SEND(_delegate->onReadMemory(*this, address, length, data));
 
+  data.resize(EscapedPrefixLength(
+      std::string_view(reinterpret_cast<char const *>(data.data()),
+                       data.size()),
+      getMaxReplyPayloadSize()));
+
   send(data);
 }
 
@@ -13,15 +13,16 @@
 #include "DebugServer2/Utils/HexValues.h"
 #include "DebugServer2/Utils/Log.h"
 
-#include <iomanip>
 #include <sstream>
 
 namespace ds2 {
 namespace GDBRemote {
 
 SessionBase::SessionBase(CompatibilityMode mode)
-    : _channel(nullptr), _delegate(nullptr), _ackmode(true), _compatMode(mode) {
+    : _channel(nullptr), _delegate(nullptr), _ackmode(true),
+      _pendingAck(false), _runLengthEncoding(false), _compatMode(mode) {
   _processor.setDelegate(&_interpreter);
+  _processor.setMaxPayloadSize(_packetSize.receive - kPacketFramingSize);
   _interpreter.setSession(this);
 }
 
@@ -40,7 +41,7 @@ bool SessionBase::receive(bool cooked) {
   if (!_channel->wait())
     return false;
 
-  std::string data;
+  std::string &data = _receiveBuffer;
 
   if (!_channel->receive(data))
     return false;
@@ -61,7 +62,7 @@ bool SessionBase::receive(bool cooked) {
   return parse(data);
 }
 
-bool SessionBase::parse(std::string const &data) {
+bool SessionBase::parse(std::string_view data) {
   if (data.empty())
     return false;
 
@@ -84,15 +85,28 @@ bool SessionBase::onNAK() {
 
 bool SessionBase::onCommandReceived(bool valid) {
   //
-  // Send ACK or NAK if in acknowledge mode.
+  // Send ACK or NAK if in acknowledge mode. The ACK is held back so that it
+  // goes out in the same write as the reply; flush() sends it on its own if
+  // the command didn't produce one.
   //
   if (!_ackmode)
     return true;
 
-  return valid ? sendACK() : sendNAK();
+  if (!valid)
+    return sendNAK();
+
+  _pendingAck = true;
+  return true;
+}
+
+bool SessionBase::flush() {
+  if (!_pendingAck.exchange(false))
+    return true;
+
+  return sendACK();
 }
 
-void SessionBase::onInvalidData(std::string const &) {
+void SessionBase::onInvalidData(std::string_view) {
   //
   // Send NAK in acknowledge mode.
   //
@@ -106,6 +120,144 @@ bool SessionBase::sendACK() { return _channel->send("+", 1) == 1; }
 
 bool SessionBase::sendNAK() { return _channel->send("-", 1) == 1; }
 
+namespace {
+
+//
+// Appends the escaped and, if requested, run-length encoded form of `data`
+// to `out` and returns the checksum of what was appended.
+//
+// A run of the same character is sent as the character followed by '*' and
+// a repeat count encoded as count + 29. Counts that would produce '#' or '$'
+// (packet delimiters) or '+' and '-' (acknowledgements) are shortened and
+// the remainder sent as is. Escape sequences are never part of a run.
+//
+uint8_t EncodePayload(std::string_view data, bool escape, bool escaped,
+                      bool runLengthEncoding, std::string &out) {
+  static size_t const kMinRepeat = 3;
+  static size_t const kMaxRepeat = '~' - 29;
+
+  uint8_t csum = 0;
+  auto put = [&out, &csum](char c) {
+    out += c;
+    csum += c;
+  };
+
+  size_t n = 0;
+  while (n < data.size()) {
+    //
+    // Copy whatever needs neither escaping nor run-length encoding in bulk.
+    //
+    size_t next = FindEscapableOrRun(data, n, runLengthEncoding);
+    if (next != n) {
+      std::string_view plain = data.substr(n, next - n);
+      out.append(plain);
+      csum += Checksum(plain);
+      n = next;
+      if (n == data.size())
+        break;
+    }
+
+    char c = data[n++];
+
+    if (escape && (c == '$' || c == '#' || c == '}' || c == '*')) {
+      put('}');
+      put(c ^ 0x20);
+      continue;
+    }
+
+    put(c);
+
+    if (escaped && c == '}') {
+      if (n < data.size()) {
+        put(data[n++]);
+      }
+      continue;
+    }
+
+    if (!runLengthEncoding)
+      continue;
+
+    size_t repeat = 0;
+    while (n + repeat < data.size() && data[n + repeat] == c &&
+           repeat < kMaxRepeat) {
+      repeat++;
+    }
+
+    while (repeat == '#' - 29 || repeat == '$' - 29 || repeat == '+' - 29 ||
+           repeat == '-' - 29) {
+      repeat--;
+    }
+
+    if (repeat >= kMinRepeat) {
+      put('*');
+      put(static_cast<char>(repeat + 29));
+      n += repeat;
+    }
+  }
+
+  return csum;
+}
+} // namespace
+
+bool SessionBase::send(std::string_view data, bool escaped) {
+  bool escape = !escaped && FindEscapable(data) != data.size();
+  char trailer[3];
+
+  //
+  // Nothing to transform: frame the caller's buffer in place instead of
+  // copying it.
+  //
+  if (!escape && !_runLengthEncoding &&
+      _compression.type == kCompressionTypeNone) {
+    uint8_t csum = Checksum(data);
+    trailer[0] = '#';
+    trailer[1] = NibbleToHex(csum >> 4);
+    trailer[2] = NibbleToHex(csum & 15);
+
+    DS2LOG(Packet, "putpkt(\"$%.*s%.3s\", %u)", static_cast<int>(data.size()),
+           data.data(), trailer, static_cast<unsigned>(data.size() + 4));
+
+    std::string_view header = _pendingAck.exchange(false) ? "+$" : "$";
+    Host::Channel::Buffer const buffers[] = {
+        {header.data(), header.size()},
+        {data.data(), data.size()},
+        {trailer, sizeof(trailer)}};
+    return _channel->sendv(buffers, sizeof(buffers) / sizeof(buffers[0]));
+  }
+
+  _sendBuffer.clear();
+  if (_pendingAck.exchange(false)) {
+    _sendBuffer += '+';
+  }
+  size_t start = _sendBuffer.size();
+  _sendBuffer += '$';
+
+  uint8_t csum;
+  if (_compression.type != kCompressionTypeNone) {
+    //
+    // Once compression has been enabled, every packet is framed, whether or
+    // not its payload actually got compressed.
+    //
+    _payloadBuffer.clear();
+    EncodePayload(data, escape, escaped, _runLengthEncoding, _payloadBuffer);
+    FrameCompressedPayload(_compression.type, _compression.minSize,
+                           _payloadBuffer, _sendBuffer);
+    csum = Checksum(std::string_view(_sendBuffer).substr(start + 1));
+  } else {
+    csum = EncodePayload(data, escape, escaped, _runLengthEncoding,
+                         _sendBuffer);
+  }
+
+  _sendBuffer += '#';
+  _sendBuffer += NibbleToHex(csum >> 4);
+  _sendBuffer += NibbleToHex(csum & 15);
+
+  DS2LOG(Packet, "putpkt(\"%s\", %u)", _sendBuffer.c_str() + start,
+         static_cast<unsigned>(_sendBuffer.length() - start));
+
+  return _channel->send(_sendBuffer);
+}
+
 // The GDB protocol specifies whitespace in some packets. However,
 // lldb-server does not use this whitespace, and older versions of
 // lldb will fail if it is used. Don't use a separator in lldb mode.
@@ -559,7 +559,7 @@ JSDictionary *StopInfo::encodeJson() const {
   if (!threadName.empty())
     threadObj->set("name", JSString::New(threadName));
 
-  if (core)
+  if (core >= 0)
     threadObj->set("core", JSInteger::New(core));
 
   if (watchpointAddress) {
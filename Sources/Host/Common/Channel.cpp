@@ -20,6 +20,19 @@ bool Channel::send(std::string const &buffer) {
   return send(&buffer[0], buffer.size()) == static_cast<ssize_t>(buffer.size());
 }
 
+bool Channel::sendv(Buffer const *buffers, size_t count) {
+  if (!connected())
+    return false;
+
+  for (size_t n = 0; n < count; n++) {
+    if (send(buffers[n].data, buffers[n].length) !=
+        static_cast<ssize_t>(buffers[n].length))
+      return false;
+  }
+
+  return true;
+}
+
 bool Channel::receive(std::string &buffer) {
   if (!connected())
     return false;
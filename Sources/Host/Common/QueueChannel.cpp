@@ -44,6 +44,14 @@ ssize_t QueueChannel::send(void const *buffer, size_t length) {
   return _remote->send(buffer, length);
 }
 
+bool QueueChannel::sendv(Buffer const *buffers, size_t count) {
+  // Forward to the remote
+  if (!connected())
+    return false;
+
+  return _remote->sendv(buffers, count);
+}
+
 //
 // This method is for compatibility, the code should always call
 // receive(std::string&) when using a QueueChannel, which is the
@@ -63,7 +71,9 @@ bool QueueChannel::receive(std::string &buffer) {
   if (!connected())
     return false;
 
-  buffer = _queue.get(0);
+  if (!_queue.get(buffer, 0)) {
+    buffer.clear();
+  }
   return true;
 }
 } // namespace Host
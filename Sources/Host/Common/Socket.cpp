@@ -29,7 +29,10 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #define SOCK_ERRNO errno
@@ -48,10 +51,12 @@ namespace ds2 {
 namespace Host {
 
 Socket::Socket()
-    : _handle(INVALID_SOCKET), _state(State::Invalid), _lastError(0) {}
+    : _handle(INVALID_SOCKET), _state(State::Invalid), _lastError(0),
+      _lowLatency(false) {}
 
 Socket::Socket(SOCKET handle)
-    : _handle(handle), _state(State::Connected), _lastError(0) {
+    : _handle(handle), _state(State::Connected), _lastError(0),
+      _lowLatency(false) {
 #if defined(OS_POSIX)
   ::fcntl(_handle, F_SETFD, FD_CLOEXEC);
   ::fcntl(_handle, F_SETFL, O_NONBLOCK);
@@ -330,22 +335,152 @@ bool Socket::setNonBlocking() {
   return true;
 }
 
+bool Socket::setLowLatency(size_t bufferSize) {
+  if (!connected()) {
+    return false;
+  }
+
+  auto setOption = [this](int level, int name, int value, char const *what) {
+    if (::setsockopt(_handle, level, name, reinterpret_cast<char *>(&value),
+                     sizeof(value)) != 0) {
+      DS2LOG(Debug, "cannot set %s on socket: %s", what,
+             SOCK_ERRNO_STRINGIFY(SOCK_ERRNO));
+      return false;
+    }
+    return true;
+  };
+
+  //
+  // TCP options fail on UNIX sockets, which don't need them anyway.
+  //
+  bool success = setOption(IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+#if defined(TCP_QUICKACK)
+  success = setOption(IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK") && success;
+#endif
+  setOption(SOL_SOCKET, SO_SNDBUF, static_cast<int>(bufferSize), "SO_SNDBUF");
+  setOption(SOL_SOCKET, SO_RCVBUF, static_cast<int>(bufferSize), "SO_RCVBUF");
+#if defined(SO_BUSY_POLL)
+  //
+  // Raising the busy poll time above net.core.busy_read needs privileges,
+  // do without when we don't have them.
+  //
+  static int const kBusyPollMicroseconds = 50;
+  setOption(SOL_SOCKET, SO_BUSY_POLL, kBusyPollMicroseconds, "SO_BUSY_POLL");
+#endif
+
+  _lowLatency = success;
+  return success;
+}
+
 ssize_t Socket::send(void const *buffer, size_t length) {
   if (!connected()) {
     return -1;
   }
 
-  ssize_t nsent =
-      ::send(_handle, reinterpret_cast<const char *>(buffer), length, 0);
+  //
+  // The socket is non-blocking, so a reply larger than the socket buffer
+  // (e.g. jThreadsInfo with thousands of threads) only goes out once the
+  // other side has read the beginning of it.
+  //
+  size_t total = 0;
+  while (total < length) {
+    ssize_t nsent =
+        ::send(_handle, reinterpret_cast<const char *>(buffer) + total,
+               length - total, 0);
+    if (nsent < 0) {
+      int err = SOCK_ERRNO;
+#if defined(OS_POSIX)
+      if (err == EINTR)
+        continue;
+#endif
+      if (err == SOCK_WOULDBLOCK && waitWritable())
+        continue;
+
+      if (err != SOCK_WOULDBLOCK) {
+        close();
+        _lastError = err;
+      }
+      return total > 0 ? static_cast<ssize_t>(total) : -1;
+    }
+    total += nsent;
+  }
+  return total;
+}
+
+bool Socket::sendv(Buffer const *buffers, size_t count) {
+  static size_t const kMaxBuffers = 8;
+
+  if (!connected()) {
+    return false;
+  }
+
+  if (count > kMaxBuffers) {
+    return Channel::sendv(buffers, count);
+  }
+
+  size_t total = 0;
+#if defined(OS_WIN32)
+  WSABUF wsabufs[kMaxBuffers];
+  for (size_t n = 0; n < count; n++) {
+    wsabufs[n].buf =
+        const_cast<char *>(static_cast<char const *>(buffers[n].data));
+    wsabufs[n].len = static_cast<ULONG>(buffers[n].length);
+    total += buffers[n].length;
+  }
+
+  DWORD sent = 0;
+  ssize_t nsent = -1;
+  if (::WSASend(_handle, wsabufs, static_cast<DWORD>(count), &sent, 0, nullptr,
+                nullptr) == 0) {
+    nsent = sent;
+  }
+#else
+  struct iovec iov[kMaxBuffers];
+  for (size_t n = 0; n < count; n++) {
+    iov[n].iov_base = const_cast<void *>(buffers[n].data);
+    iov[n].iov_len = buffers[n].length;
+    total += buffers[n].length;
+  }
+
+  struct msghdr msg = {};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+  ssize_t nsent;
+  do {
+    nsent = ::sendmsg(_handle, &msg, 0);
+  } while (nsent < 0 && errno == EINTR);
+#endif
   if (nsent < 0) {
     int err = SOCK_ERRNO;
     if (err != SOCK_WOULDBLOCK) {
       close();
       _lastError = err;
+      return false;
     }
-    return -1;
+    nsent = 0;
+  }
+
+  if (static_cast<size_t>(nsent) == total)
+    return true;
+
+  //
+  // The socket buffer filled up, send what's left one buffer at a time.
+  //
+  size_t skip = nsent;
+  for (size_t n = 0; n < count; n++) {
+    if (skip >= buffers[n].length) {
+      skip -= buffers[n].length;
+      continue;
+    }
+
+    size_t length = buffers[n].length - skip;
+    if (send(static_cast<char const *>(buffers[n].data) + skip, length) !=
+        static_cast<ssize_t>(length))
+      return false;
+    skip = 0;
   }
-  return nsent;
+
+  return true;
 }
 
 ssize_t Socket::receive(void *buffer, size_t length) {
@@ -367,6 +502,17 @@ ssize_t Socket::receive(void *buffer, size_t length) {
     nrecvd = 0;
   }
 
+#if defined(TCP_QUICKACK)
+  //
+  // Linux falls back to delayed ACKs on its own, turn quick ACKs back on
+  // after every read.
+  //
+  if (_lowLatency && nrecvd > 0) {
+    int yes = 1;
+    ::setsockopt(_handle, IPPROTO_TCP, TCP_QUICKACK, &yes, sizeof(yes));
+  }
+#endif
+
   return nrecvd;
 }
 
@@ -399,6 +545,24 @@ bool Socket::wait(int ms) {
 #endif
 }
 
+bool Socket::waitWritable() {
+#if defined(OS_WIN32)
+  fd_set fds;
+  FD_ZERO(&fds);
+  FD_SET(_handle, &fds);
+  return ::select(_handle + 1, nullptr, &fds, nullptr, nullptr) == 1;
+#else
+  struct pollfd pfd;
+  pfd.fd = _handle;
+  pfd.events = POLLOUT;
+  int nfds;
+  do {
+    nfds = ::poll(&pfd, 1, -1);
+  } while (nfds < 0 && errno == EINTR);
+  return (nfds == 1 && (pfd.revents & POLLOUT) != 0);
+#endif
+}
+
 std::string Socket::error() const {
 #if defined(OS_WIN32)
   // 128 bytes is enough for "error " + "0x00000000"
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Host/Linux/EventLoop.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace ds2 {
+namespace Host {
+namespace Linux {
+
+namespace {
+int sEpoll = -1;
+std::unordered_map<int, EventLoop::Handler> sHandlers;
+} // namespace
+
+bool EventLoop::Add(int fd, Handler handler) {
+  if (sEpoll < 0) {
+    sEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (sEpoll < 0) {
+      DS2LOG(Error, "cannot create event loop: %s", strerror(errno));
+      return false;
+    }
+  }
+
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  if (::epoll_ctl(sEpoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+    DS2LOG(Error, "cannot watch fd %d: %s", fd, strerror(errno));
+    return false;
+  }
+
+  sHandlers[fd] = std::move(handler);
+  return true;
+}
+
+void EventLoop::Remove(int fd) {
+  if (sHandlers.erase(fd) == 0)
+    return;
+
+  // The descriptor may already be closed, which removed it from the set.
+  (void)::epoll_ctl(sEpoll, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+bool EventLoop::Wait(int ms) {
+  if (sHandlers.empty())
+    return false;
+
+  struct epoll_event events[8];
+  int count;
+  do {
+    count = ::epoll_wait(sEpoll, events, 8, ms);
+  } while (count < 0 && errno == EINTR);
+
+  if (count < 0) {
+    DS2LOG(Error, "cannot wait for events: %s", strerror(errno));
+    return false;
+  }
+
+  for (int n = 0; n < count; n++) {
+    // An earlier handler may have removed this descriptor; run a copy of the
+    // handler, which may remove itself.
+    auto it = sHandlers.find(events[n].data.fd);
+    if (it == sHandlers.end())
+      continue;
+
+    Handler handler = it->second;
+    handler();
+  }
+
+  return true;
+}
+} // namespace Linux
+} // namespace Host
+} // namespace ds2
@@ -48,6 +48,18 @@ ErrorCode PTrace::wait(ProcessThreadId const &ptid, int *status) {
   return kSuccess;
 }
 
+//
+// Trace clone events to track threads; trace fork/vfork for the
+// fork-events/vfork-events GDB-remote extension (the forked child is
+// detached once its initial ptrace stop is collected, so it doesn't get
+// consumed as a thread in the parent process); trace vfork-done so the
+// parent's stop after the child execs/exits is also reported; trace exec
+// so cached process information can be dropped when the image changes.
+//
+static constexpr unsigned long kTraceFlags =
+    PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK |
+    PTRACE_O_TRACEVFORKDONE | PTRACE_O_TRACEEXEC;
+
 ErrorCode PTrace::traceMe(bool disableASLR) {
   if (disableASLR) {
     int persona = ::personality(std::numeric_limits<uint32_t>::max());
@@ -56,23 +68,98 @@ ErrorCode PTrace::traceMe(bool disableASLR) {
     }
   }
 
-  return super::traceMe(false);
+  //
+  // PTRACE_INTERRUPT and PTRACE_LISTEN only work on tracees attached with
+  // PTRACE_SEIZE, which PTRACE_TRACEME can't do. Stop here instead and let
+  // the parent seize us, see traceChild.
+  //
+  if (::raise(SIGSTOP) != 0)
+    return Platform::TranslateError();
+
+  return kSuccess;
 }
 
-ErrorCode PTrace::traceThat(ProcessId pid) {
+ErrorCode PTrace::traceChild(ProcessId pid, int *status) {
   if (pid <= 0)
     return kErrorInvalidArgument;
 
+  int stat;
+  pid_t ret;
+  do {
+    ret = ::waitpid(pid, &stat, WUNTRACED);
+  } while (ret < 0 && errno == EINTR);
+  if (ret != pid)
+    return kErrorProcessNotFound;
+
+  if (WIFSTOPPED(stat)) {
+    if (wrapPtrace(PTRACE_SEIZE, pid, nullptr, kTraceFlags) < 0)
+      return Platform::TranslateError();
+
+    //
+    // End the group-stop the child put itself in; otherwise the kernel keeps
+    // reporting SIGSTOP instead of SIGTRAP for PTRACE_INTERRUPT stops. The
+    // stops this generates before exec are swallowed along with SIGCONT
+    // itself, the child has nothing to run but execve(2).
+    //
+    ::kill(pid, SIGCONT);
+
+    for (;;) {
+      CHK(wait(pid, &stat));
+      if (!WIFSTOPPED(stat) ||
+          (stat >> 8) == (SIGTRAP | (PTRACE_EVENT_EXEC << 8)))
+        break;
+
+      if (wrapPtrace(PTRACE_CONT, pid, nullptr, 0) < 0)
+        return Platform::TranslateError();
+    }
+  }
+
+  if (status != nullptr) {
+    *status = stat;
+  }
+
+  return kSuccess;
+}
+
+ErrorCode PTrace::attach(ProcessId pid) {
+  if (pid <= kAnyProcessId)
+    return kErrorProcessNotFound;
+
+  DS2LOG(Debug, "seizing pid %" PRIu64, (uint64_t)pid);
+
+  if (wrapPtrace(PTRACE_SEIZE, pid, nullptr, kTraceFlags) < 0)
+    return Platform::TranslateError();
+
   //
-  // Trace clone events to track threads; trace fork/vfork for the
-  // fork-events/vfork-events GDB-remote extension (the forked child is
-  // detached once its initial ptrace stop is collected, so it doesn't get
-  // consumed as a thread in the parent process); trace vfork-done so the
-  // parent's stop after the child execs/exits is also reported.
+  // Unlike PTRACE_ATTACH, seizing doesn't stop the tracee; the stop we ask
+  // for is reported as a PTRACE_EVENT_STOP.
   //
-  static constexpr unsigned long kTraceFlags =
-      PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK |
-      PTRACE_O_TRACEVFORKDONE;
+  return suspend(pid);
+}
+
+ErrorCode PTrace::suspend(ProcessThreadId const &ptid) {
+  pid_t pid;
+  CHK(ptidToPid(ptid, pid));
+
+  if (wrapPtrace(PTRACE_INTERRUPT, pid, nullptr, nullptr) < 0)
+    return Platform::TranslateError();
+
+  return kSuccess;
+}
+
+ErrorCode PTrace::listen(ProcessThreadId const &ptid) {
+  pid_t pid;
+  CHK(ptidToPid(ptid, pid));
+
+  if (wrapPtrace(PTRACE_LISTEN, pid, nullptr, nullptr) < 0)
+    return Platform::TranslateError();
+
+  return kSuccess;
+}
+
+ErrorCode PTrace::traceThat(ProcessId pid) {
+  if (pid <= 0)
+    return kErrorInvalidArgument;
 
   if (wrapPtrace(PTRACE_SETOPTIONS, pid, nullptr, kTraceFlags) < 0) {
     DS2LOG(Warning, "unable to set ptrace trace options on pid %d, error=%s",
@@ -2,8 +2,10 @@
 
 #include "DebugServer2/Host/POSIX/HandleChannel.h"
 
+#include <cerrno>
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/uio.h>
 
 namespace ds2 {
 namespace Host {
@@ -47,6 +49,66 @@ ssize_t HandleChannel::send(void const *buffer, size_t length) {
   return -1;
 }
 
+bool HandleChannel::sendv(Buffer const *buffers, size_t count) {
+  static size_t const kMaxBuffers = 8;
+
+  if (fd_ < 0)
+    return false;
+
+  if (count > kMaxBuffers)
+    return Channel::sendv(buffers, count);
+
+  struct iovec iov[kMaxBuffers];
+  size_t niov = 0;
+  for (size_t n = 0; n < count; n++) {
+    if (buffers[n].length == 0)
+      continue;
+    iov[niov].iov_base = const_cast<void *>(buffers[n].data);
+    iov[niov].iov_len = buffers[n].length;
+    niov++;
+  }
+
+  size_t first = 0;
+  while (first < niov) {
+    ssize_t nwritten = ::writev(fd_, iov + first, niov - first);
+    if (nwritten <= 0) {
+      if (nwritten < 0 && errno == EINTR)
+        continue;
+      if (nwritten < 0 && errno == EAGAIN && waitWritable())
+        continue;
+
+      close();
+      return false;
+    }
+
+    //
+    // writev can stop in the middle of a buffer, pick up from there.
+    //
+    size_t skip = nwritten;
+    while (first < niov && skip >= iov[first].iov_len) {
+      skip -= iov[first].iov_len;
+      first++;
+    }
+    if (first < niov) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + skip;
+      iov[first].iov_len -= skip;
+    }
+  }
+
+  return true;
+}
+
+bool HandleChannel::waitWritable() {
+  struct pollfd fds;
+  fds.fd = fd_;
+  fds.events = POLLOUT;
+  int nfds;
+  do {
+    nfds = ::poll(&fds, 1, -1);
+  } while (nfds < 0 && errno == EINTR);
+  return nfds == 1 && (fds.revents & POLLOUT);
+}
+
 ssize_t HandleChannel::receive(void *buffer, size_t length) {
   if (fd_ < 0)
     return -1;
@@ -58,6 +58,10 @@ ErrorCode PTrace::traceMe(bool disableASLR) {
   return kSuccess;
 }
 
+ErrorCode PTrace::traceChild(ProcessId pid, int *status) {
+  return wait(pid, status);
+}
+
 ErrorCode PTrace::attach(ProcessId pid) {
   if (pid <= kAnyProcessId)
     return kErrorProcessNotFound;
@@ -35,8 +35,26 @@ extern char **environ;
 namespace ds2 {
 namespace Host {
 
+// The signal mask we were started with, before Initialize changed it.
+static sigset_t sInitialSignalMask;
+
 void Platform::Initialize() {
-  // Nothing to do here.
+  ::pthread_sigmask(SIG_SETMASK, nullptr, &sInitialSignalMask);
+
+#if defined(OS_LINUX)
+  // The Linux backend reads SIGCHLD from a signalfd to learn about inferior
+  // events, which only works if no thread of ours can take the signal. Block
+  // it here, before any thread is started, so that all of them inherit the
+  // mask.
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  ::pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+#endif
+}
+
+void Platform::RestoreInitialSignalMask() {
+  ::sigprocmask(SIG_SETMASK, &sInitialSignalMask, nullptr);
 }
 
 size_t Platform::GetPageSize() {
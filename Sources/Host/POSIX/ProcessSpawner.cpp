@@ -10,6 +10,7 @@
 
 #include "DebugServer2/Base.h"
 #if defined(OS_LINUX)
+#include "DebugServer2/Host/Linux/EventLoop.h"
 #include "DebugServer2/Host/Linux/ExtraWrappers.h"
 #endif
 #include "DebugServer2/Host/Platform.h"
@@ -24,6 +25,7 @@
 #include <fcntl.h>
 #include <libgen.h>
 #include <poll.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -77,11 +79,32 @@ static inline void close_terminal(int fds[2]) {
 ProcessSpawner::ProcessSpawner()
     : _exitStatus(0), _signalCode(0), _pid(0), _shell(false) {}
 
-ProcessSpawner::~ProcessSpawner() { flushAndExit(); }
+ProcessSpawner::~ProcessSpawner() {
+  flushAndExit();
+  closeRedirections();
+}
 
 void ProcessSpawner::flushAndExit() {
   if (_delegateThread.joinable())
     _delegateThread.join();
+
+#if defined(OS_LINUX)
+  //
+  // Pick up what the inferior wrote last that the event loop hasn't read
+  // yet. The terminal is closed when the event loop sees its last holder
+  // close it, which may not be the inferior.
+  //
+  for (auto &descriptor : _descriptors) {
+    if (descriptor.mode != kRedirectDelegate || descriptor.fd == -1)
+      continue;
+
+    struct pollfd pfd = {descriptor.fd, POLLIN, 0};
+    while (::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0 &&
+           forwardOutput(descriptor) > 0)
+      continue;
+    break;
+  }
+#endif
 }
 
 bool ProcessSpawner::setExecutable(std::string const &path) {
@@ -415,6 +438,11 @@ ErrorCode ProcessSpawner::run(std::function<bool()> preExecAction) {
   }
 
   if (_pid == 0) {
+    // Don't hand down the signal mask of the debug server (see
+    // Platform::Initialize), but keep whatever was blocked when we were
+    // started, as the inferior would have inherited it from our parent.
+    Platform::RestoreInitialSignalMask();
+
     for (size_t n = 0; n < 3; n++) {
       switch (_descriptors[n].mode) {
       case kRedirectConsole:
@@ -518,6 +546,27 @@ ErrorCode ProcessSpawner::run(std::function<bool()> preExecAction) {
     }
   }
 
+  if (startRedirectThread) {
+#if defined(OS_LINUX)
+    //
+    // Output for the debugger is read from the event loop, like everything
+    // else the debug server waits on; see Host::Linux::EventLoop.
+    //
+    for (auto &descriptor : _descriptors) {
+      if (descriptor.mode != kRedirectDelegate)
+        continue;
+
+      startRedirectThread = !Linux::EventLoop::Add(
+          descriptor.fd, [this, &descriptor]() {
+            ssize_t nread = forwardOutput(descriptor);
+            if (nread == 0 || (nread < 0 && errno != EINTR && errno != EAGAIN))
+              closeRedirections();
+          });
+      break;
+    }
+#endif
+  }
+
   if (startRedirectThread) {
     _delegateThread = std::thread(&ProcessSpawner::redirectionThread, this);
   }
@@ -547,9 +596,9 @@ ErrorCode ProcessSpawner::wait() {
   }
 
   //
-  // Wait also the termination of the thread.
+  // Wait also for the output to be read.
   //
-  _delegateThread.join();
+  flushAndExit();
 
   _pid = 0;
   if (WIFEXITED(status)) {
@@ -620,14 +669,7 @@ void ProcessSpawner::redirectionThread() {
 
       if (pfds[n].events & POLLIN) {
         if (pfds[n].revents & POLLIN) {
-          char buf[128];
-          ssize_t nread = ::read(pfds[n].fd, buf, sizeof(buf));
-          if (nread > 0) {
-            if (descriptor->mode == kRedirectBuffer) {
-              _outputBuffer.insert(_outputBuffer.end(), &buf[0], &buf[nread]);
-            } else {
-              descriptor->delegate(buf, nread);
-            }
+          if (forwardOutput(*descriptor) > 0) {
             done = true;
           }
         }
@@ -638,10 +680,47 @@ void ProcessSpawner::redirectionThread() {
       break;
   }
 
-  for (auto &_descriptor : _descriptors) {
-    if (_descriptor.fd != -1) {
-      ::close(_descriptor.fd);
-      _descriptor.fd = -1;
+  closeRedirections();
+}
+
+//
+// Reads one chunk of what the inferior wrote and hands it over; returns what
+// read(2) did.
+//
+ssize_t ProcessSpawner::forwardOutput(RedirectDescriptor &descriptor) {
+  char buf[128];
+  ssize_t nread = ::read(descriptor.fd, buf, sizeof(buf));
+  if (nread > 0) {
+    if (descriptor.mode == kRedirectBuffer) {
+      _outputBuffer.insert(_outputBuffer.end(), &buf[0], &buf[nread]);
+    } else {
+      descriptor.delegate(buf, nread);
+    }
+  }
+  return nread;
+}
+
+void ProcessSpawner::closeRedirections() {
+#if defined(OS_LINUX)
+  for (auto &descriptor : _descriptors) {
+    if (descriptor.mode == kRedirectDelegate && descriptor.fd != -1) {
+      Linux::EventLoop::Remove(descriptor.fd);
+    }
+  }
+#endif
+
+  for (auto &descriptor : _descriptors) {
+    int fd = descriptor.fd;
+    if (fd == -1)
+      continue;
+
+    ::close(fd);
+
+    // The terminal backs several descriptors, close it once.
+    for (auto &other : _descriptors) {
+      if (other.fd == fd) {
+        other.fd = -1;
+      }
     }
   }
 }
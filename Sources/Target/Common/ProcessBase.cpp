@@ -15,6 +15,7 @@
 #include "DebugServer2/Utils/Log.h"
 #include "DebugServer2/Utils/Stringify.h"
 
+#include <atomic>
 #include <list>
 
 using ds2::Utils::Stringify;
@@ -34,15 +35,27 @@ ProcessBase::~ProcessBase() {
   _currentThread = nullptr;
 }
 
-ErrorCode ProcessBase::getInfo(ProcessInfo &info) {
+ErrorCode ProcessBase::getInfo(ProcessInfo &info, bool refresh) {
   ErrorCode error = updateInfo();
-  if (error == kSuccess || error == kErrorAlreadyExist) {
+  if (error == kSuccess) {
+    // Freshly read, nothing to refresh.
+    info = _info;
+  } else if (error == kErrorAlreadyExist) {
+    error = refresh ? refreshInfo() : kSuccess;
     info = _info;
-    error = kSuccess;
   }
   return error;
 }
 
+ErrorCode ProcessBase::refreshInfo() { return kSuccess; }
+
+void ProcessBase::invalidateInfo() {
+  static std::atomic<uint64_t> sExecGeneration(0);
+
+  _info.clear();
+  _execGeneration = ++sExecGeneration;
+}
+
 // This is a utility function for detach.
 void ProcessBase::cleanup() {
   std::set<Thread *> threads;
@@ -67,6 +80,8 @@ ErrorCode ProcessBase::initialize(ProcessId pid, uint32_t flags) {
   //
   // Update process information immediatly.
   //
+  invalidateInfo();
+  invalidateMemoryCache();
   ErrorCode error = updateInfo();
   if (error != kSuccess) {
     _pid = kAnyProcessId;
@@ -108,8 +123,9 @@ ErrorCode ProcessBase::suspend() {
         DS2LOG(Debug,
                "tried to suspended tid %" PRI_PID " which is already dead",
                thread->tid());
+        // Keep going, the other threads still have to be suspended.
         removeThread(thread->tid());
-        return error;
+        break;
 
       default:
         DS2LOG(Warning, "failed suspending tid %" PRI_PID ", error=%s",
@@ -255,9 +271,7 @@ ErrorCode ProcessBase::writeMemoryBuffer(Address const &address,
 }
 
 void ProcessBase::insert(ThreadBase *thread) {
-  if (!_threads
-           .insert(std::make_pair(thread->tid(), static_cast<Thread *>(thread)))
-           .second)
+  if (!_threads.insert(thread->tid(), static_cast<Thread *>(thread)))
     return;
 
   DS2LOG(Debug, "[new Thread %" PRI_PTR " (LWP %" PRIu64 ")]",
@@ -345,6 +359,12 @@ void ProcessBase::prepareForDetach() {
   if (bpm != nullptr) {
     bpm->clear();
   }
+
+  // Registers modified while stopped are only written back on resume, which
+  // won't happen through us after detaching.
+  for (auto const &it : _threads) {
+    it.second->flushCPUState();
+  }
 }
 } // namespace Target
 } // namespace ds2
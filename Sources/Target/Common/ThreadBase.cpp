@@ -9,6 +9,7 @@
 //
 
 #include "DebugServer2/Target/ThreadBase.h"
+#include "DebugServer2/Host/Platform.h"
 #include "DebugServer2/Target/Process.h"
 
 namespace ds2 {
@@ -23,6 +24,10 @@ ThreadBase::ThreadBase(Process *process, ThreadId tid)
   _process->insert(this);
 }
 
+std::string ThreadBase::name(bool) const {
+  return Host::Platform::GetThreadName(_process->pid(), _tid);
+}
+
 ErrorCode ThreadBase::modifyRegisters(
     std::function<void(Architecture::CPUState &state)> action) {
   Architecture::CPUState state;
@@ -31,6 +36,12 @@ ErrorCode ThreadBase::modifyRegisters(
   return writeCPUState(state);
 }
 
+// Backends that don't cache register state have nothing to write back.
+ErrorCode ThreadBase::flushCPUState() {
+  DS2ASSERT(!_cpuStateCache.dirty);
+  return kSuccess;
+}
+
 ErrorCode ThreadBase::beforeResume() {
   BreakpointManager *bpm = _process->hardwareBreakpointManager();
   if (bpm != nullptr) {
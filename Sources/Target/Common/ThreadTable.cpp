@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Target/ThreadTable.h"
+#include "DebugServer2/Utils/Log.h"
+
+namespace ds2 {
+namespace Target {
+
+static size_t const kInitialIndexSize = 64;
+
+// Thread ids are mostly allocated sequentially; multiplying by an odd
+// constant keeps runs of them from piling up in neighbouring slots.
+static inline size_t HashThreadId(ThreadId tid) {
+  return static_cast<size_t>(static_cast<uint64_t>(tid) *
+                             0x9e3779b97f4a7c15ULL);
+}
+
+// Returns the index slot holding `tid`, or the empty slot that ends its
+// probe sequence.
+size_t ThreadTable::slot(ThreadId tid) const {
+  size_t mask = _index.size() - 1;
+  size_t i = HashThreadId(tid) & mask;
+  while (_index[i] != 0 && _entries[_index[i] - 1].first != tid) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+ThreadTable::iterator ThreadTable::find(ThreadId tid) {
+  if (_entries.empty())
+    return end();
+
+  size_t i = slot(tid);
+  return _index[i] == 0 ? end() : begin() + (_index[i] - 1);
+}
+
+ThreadTable::const_iterator ThreadTable::find(ThreadId tid) const {
+  if (_entries.empty())
+    return end();
+
+  size_t i = slot(tid);
+  return _index[i] == 0 ? end() : begin() + (_index[i] - 1);
+}
+
+bool ThreadTable::insert(ThreadId tid, Thread *thread) {
+  // Keep the index at most half full so that probe sequences stay short.
+  if ((_entries.size() + 1) * 2 > _index.size()) {
+    grow();
+  }
+
+  size_t i = slot(tid);
+  if (_index[i] != 0)
+    return false;
+
+  _entries.emplace_back(tid, thread);
+  _index[i] = static_cast<uint32_t>(_entries.size());
+  return true;
+}
+
+void ThreadTable::erase(iterator it) {
+  DS2ASSERT(it != end());
+
+  size_t mask = _index.size() - 1;
+  size_t position = it - begin();
+
+  //
+  // Empty the slot, then shift back the entries that follow it in the same
+  // cluster and could not be placed at their home slot, so that lookups
+  // never need tombstones.
+  //
+  size_t hole = slot(it->first);
+  for (size_t i = (hole + 1) & mask; _index[i] != 0; i = (i + 1) & mask) {
+    size_t home = HashThreadId(_entries[_index[i] - 1].first) & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      _index[hole] = _index[i];
+      hole = i;
+    }
+  }
+  _index[hole] = 0;
+
+  //
+  // Fill the gap in the dense array with the last entry.
+  //
+  if (position + 1 != _entries.size()) {
+    _index[slot(_entries.back().first)] = static_cast<uint32_t>(position + 1);
+    _entries[position] = _entries.back();
+  }
+  _entries.pop_back();
+}
+
+size_t ThreadTable::erase(ThreadId tid) {
+  auto it = find(tid);
+  if (it == end())
+    return 0;
+
+  erase(it);
+  return 1;
+}
+
+void ThreadTable::clear() {
+  _entries.clear();
+  _index.clear();
+}
+
+void ThreadTable::grow() {
+  size_t size = _index.empty() ? kInitialIndexSize : _index.size() * 2;
+  _index.assign(size, 0);
+
+  for (size_t n = 0; n < _entries.size(); n++) {
+    _index[slot(_entries[n].first)] = static_cast<uint32_t>(n + 1);
+  }
+}
+} // namespace Target
+} // namespace ds2
@@ -262,14 +262,11 @@ ErrorCode Process::allocateMemory(size_t size, uint32_t protection,
     return kErrorInvalidArgument;
   }
 
-  ProcessInfo info;
-  CHK(getInfo(info));
-
   //
   // We need to know if the process is running in Thumb or ARM mode.
   //
   Architecture::CPUState state;
-  CHK(ptrace().readCPUState(_currentThread->tid(), info, state));
+  CHK(_currentThread->readCPUState(state));
 
   int POSIXProtection = convertMemoryProtectionToPOSIX(protection);
 
@@ -297,14 +294,11 @@ ErrorCode Process::deallocateMemory(uint64_t address, size_t size) {
     return kErrorInvalidArgument;
   }
 
-  ProcessInfo info;
-  CHK(getInfo(info));
-
   //
   // We need to know if the process is running in Thumb or ARM mode.
   //
   Architecture::CPUState state;
-  CHK(ptrace().readCPUState(_currentThread->tid(), info, state));
+  CHK(_currentThread->readCPUState(state));
 
   ByteVector codestr;
   if (state.isThumb()) {
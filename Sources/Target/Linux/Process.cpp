@@ -10,6 +10,7 @@
 
 #include "DebugServer2/Target/Process.h"
 #include "DebugServer2/Core/BreakpointManager.h"
+#include "DebugServer2/Host/Linux/EventLoop.h"
 #include "DebugServer2/Host/Linux/ExtraWrappers.h"
 #include "DebugServer2/Host/Linux/PTrace.h"
 #include "DebugServer2/Host/Linux/ProcFS.h"
@@ -19,20 +20,28 @@
 #include "DebugServer2/Utils/String.h"
 #include "DebugServer2/Utils/Stringify.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <elf.h>
+#include <fcntl.h>
 #include <limits>
+#include <sys/eventfd.h>
 #include <sys/ptrace.h>
+#include <sys/signalfd.h>
 #include <sys/wait.h>
 #if defined(HAVE_PROCESS_VM_READV) || defined(HAVE_PROCESS_VM_WRITEV)
 #include <sys/uio.h>
 #endif
 #include <unistd.h>
+#include <vector>
 
 using ds2::Host::Platform;
+using ds2::Host::Linux::EventLoop;
 using ds2::Host::Linux::ProcFS;
 using ds2::Host::Linux::PTrace;
 using ds2::Utils::Stringify;
@@ -43,7 +52,20 @@ namespace ds2 {
 namespace Target {
 namespace Linux {
 
+Process::~Process() {
+  closeMemoryFile();
+
+  for (int fd : {_events.signal, _events.interrupt}) {
+    if (fd >= 0) {
+      EventLoop::Remove(fd);
+      ::close(fd);
+    }
+  }
+}
+
 ErrorCode Process::attach(int waitStatus) {
+  CHK(createEventLoop());
+
   if (waitStatus <= 0) {
     CHK(ptrace().attach(_pid));
     _flags |= kFlagAttachedProcess;
@@ -75,6 +97,7 @@ ErrorCode Process::attach(int waitStatus) {
 
         keepGoing = true;
         auto thread = new Thread(this, tid);
+        thread->_interruptReason = StopInfo::kReasonTrap;
         if (ptrace().attach(tid) == kSuccess) {
           int status;
           ptrace().wait(tid, &status);
@@ -89,6 +112,9 @@ ErrorCode Process::attach(int waitStatus) {
   // Create the main thread, ourselves.
   //
   _currentThread = new Thread(this, _pid);
+  if (_flags & kFlagAttachedProcess) {
+    _currentThread->_interruptReason = StopInfo::kReasonTrap;
+  }
   _currentThread->updateStopInfo(waitStatus);
 
   return kSuccess;
@@ -103,8 +129,161 @@ static pid_t blocking_waitpid(pid_t pid, int *status, int flags) {
   return ret;
 }
 
-ErrorCode Process::readMemory(Address const &address, void *data, size_t length,
-                              size_t *count) {
+ErrorCode Process::createEventLoop() {
+  //
+  // SIGCHLD is blocked in every thread of the debug server (see
+  // Platform::Initialize), so it stays pending until we read it from the
+  // signalfd instead of being discarded.
+  //
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+
+  _events.signal = ::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  _events.interrupt = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_events.signal < 0 || _events.interrupt < 0) {
+    DS2LOG(Error, "cannot create event loop: %s", strerror(errno));
+    return Platform::TranslateError();
+  }
+
+  //
+  // Both only need draining, waitForEvent() looks for what happened once the
+  // loop returns.
+  //
+  int signalFd = _events.signal;
+  int interruptFd = _events.interrupt;
+  bool added = EventLoop::Add(signalFd, [signalFd]() {
+    struct signalfd_siginfo info[8];
+    while (::read(signalFd, info, sizeof(info)) > 0)
+      continue;
+  });
+  added = added && EventLoop::Add(interruptFd, [interruptFd]() {
+    uint64_t value;
+    (void)::read(interruptFd, &value, sizeof(value));
+  });
+
+  return added ? kSuccess : kErrorUnknown;
+}
+
+// Returns the next thread with a wait status to collect, 0 if we were woken
+// up by interrupt() before any came in, or -1 if there is nothing left to
+// wait for.
+ThreadId Process::waitForEvent(int *status) {
+  for (;;) {
+    pid_t tid = ::waitpid(-1, status, __WALL | WNOHANG);
+    if (tid != 0) {
+      if (tid < 0 && errno == EINTR)
+        continue;
+      return tid;
+    }
+
+    //
+    // Nothing is pending; sleep until a SIGCHLD or an interrupt comes in,
+    // serving the client and the inferior's terminal until then. The
+    // descriptors are level-triggered and are only drained from the loop,
+    // after waking up, so nothing that happens between the waitpid() above
+    // and going back to sleep can be missed.
+    //
+    if (_events.interrupted)
+      return 0;
+
+    if (!EventLoop::Wait())
+      return -1;
+  }
+}
+
+int Process::memoryFile(bool write) {
+  if (_memFile.fd < 0 && !_memFile.unavailable) {
+    _memFile.fd = ProcFS::OpenFd(_pid, "mem", O_RDWR | O_CLOEXEC);
+    _memFile.writable = (_memFile.fd >= 0);
+    if (_memFile.fd < 0) {
+      // Writes will go through the fallbacks, but reads can still use it.
+      DS2LOG(Debug, "can't open /proc/%d/mem for writing: %s", _pid,
+             strerror(errno));
+      _memFile.fd = ProcFS::OpenFd(_pid, "mem", O_RDONLY | O_CLOEXEC);
+    }
+    if (_memFile.fd < 0) {
+      // Don't retry on every access; ptrace(2) will do.
+      DS2LOG(Debug, "can't open /proc/%d/mem: %s", _pid, strerror(errno));
+      _memFile.unavailable = true;
+    }
+  }
+
+  if (write && !_memFile.writable)
+    return -1;
+
+  return _memFile.fd;
+}
+
+void Process::closeMemoryFile() {
+  if (_memFile.fd >= 0) {
+    ::close(_memFile.fd);
+  }
+  _memFile.fd = -1;
+  _memFile.writable = false;
+  _memFile.unavailable = false;
+}
+
+#if defined(HAVE_PROCESS_VM_READV)
+// Reads `length` bytes at `address` with one remote iovec per page, so that
+// a fault only truncates the transfer at the page that caused it instead of
+// failing it entirely. Returns the number of bytes read.
+static size_t process_vm_readpages(pid_t pid, uint64_t address, uint8_t *data,
+                                   size_t length) {
+  size_t const pageSize = Platform::GetPageSize();
+  std::vector<struct iovec> remote_iov;
+  for (uint64_t cur = address, end = address + length; cur < end;) {
+    uint64_t next = std::min<uint64_t>((cur & ~(pageSize - 1)) + pageSize, end);
+    remote_iov.push_back({reinterpret_cast<void *>(cur), next - cur});
+    cur = next;
+  }
+
+  size_t nread = 0;
+  for (size_t i = 0; i < remote_iov.size(); i += IOV_MAX) {
+    size_t niov = std::min<size_t>(remote_iov.size() - i, IOV_MAX);
+    size_t batch = 0;
+    for (size_t j = i; j < i + niov; j++) {
+      batch += remote_iov[j].iov_len;
+    }
+
+    struct iovec local_iov = {data + nread, batch};
+    ssize_t ret =
+        process_vm_readv(pid, &local_iov, 1, &remote_iov[i], niov, 0);
+    if (ret <= 0) {
+      break;
+    }
+    nread += ret;
+    if (static_cast<size_t>(ret) < batch) {
+      break;
+    }
+  }
+
+  return nread;
+}
+#endif
+
+ErrorCode Process::fetchMemory(uint64_t address, void *data, size_t length,
+                               size_t *count) {
+  uint8_t *bytes = static_cast<uint8_t *>(data);
+  size_t nread = 0;
+
+  // Reading /proc/<pid>/mem goes through the same access checks as ptrace(2),
+  // so it can read pages regardless of their protection, but it does it in a
+  // single system call for the whole range. When it hits a page it can't
+  // read, it returns what it read up to that page.
+  int fd = memoryFile();
+  if (fd >= 0 && length > 0 &&
+      address <= static_cast<uint64_t>(std::numeric_limits<off64_t>::max())) {
+    ssize_t ret;
+    do {
+      ret = ::pread64(fd, data, length, address);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret > 0) {
+      nread = ret;
+    }
+  }
+
 #if defined(HAVE_PROCESS_VM_READV)
   // Using process_vm_readv() is faster than using ptrace() because we can do
   // bigger reads that ptrace() (which can only read a word at a time); the
@@ -114,48 +293,100 @@ ErrorCode Process::readMemory(Address const &address, void *data, size_t length,
   // fallback so we reduce the number of possible process_vm_readv() failures.
   // The most common occurence of this is when writing breakpoints.
 
-  if (length > sizeof(uintptr_t)) {
-    struct iovec local_iov = {data, length};
-    struct iovec remote_iov = {reinterpret_cast<void *>(address.value()),
-                               length};
+  if (length - nread > sizeof(uintptr_t)) {
     auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
-
-    ssize_t ret = process_vm_readv(id, &local_iov, 1, &remote_iov, 1, 0);
-    if (ret >= 0) {
-      if (count != nullptr) {
-        *count = ret;
-      }
-      return kSuccess;
-    }
+    nread += process_vm_readpages(id, address + nread, bytes + nread,
+                                  length - nread);
   }
 #endif
 
-  // Fallback to super::readMemory, which uses ptrace(2).
-  return super::readMemory(address, data, length, count);
+  // Fallback to ptrace(2) for whatever is left. It stops at the first word it
+  // can't read, so on failure `count` still reports the readable prefix of
+  // the range.
+  ErrorCode error = kSuccess;
+  if (nread < length) {
+    auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
+    size_t ncopied = 0;
+    error = ptrace().readMemory(id, address + nread, bytes + nread,
+                                length - nread, &ncopied);
+    nread += ncopied;
+  }
+
+  if (count != nullptr) {
+    *count = nread;
+  }
+  return error;
+}
+
+ErrorCode Process::readMemory(Address const &address, void *data, size_t length,
+                              size_t *count) {
+  size_t nread = 0;
+  ErrorCode error = _memoryCache.read(
+      address, data, length, &nread,
+      [this](uint64_t start, void *buffer, size_t size, size_t *nfetched) {
+        return fetchMemory(start, buffer, size, nfetched);
+      });
+
+  softwareBreakpointManager()->maskMemory(address, data, nread);
+
+  if (count != nullptr) {
+    *count = nread;
+  }
+  return error;
 }
 
 ErrorCode Process::writeMemory(Address const &address, void const *data,
                                size_t length, size_t *count) {
+  auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
+  ErrorCode error = kErrorUnknown;
+  size_t nwritten = 0;
+
+  // Like reads, writes to /proc/<pid>/mem can patch read-only text. Some
+  // kernels are configured to refuse them, in which case we fall back.
+  int fd = memoryFile(true);
+  if (fd >= 0 && length > 0 &&
+      address.value() <=
+          static_cast<uint64_t>(std::numeric_limits<off64_t>::max())) {
+    ssize_t ret;
+    do {
+      ret = ::pwrite64(fd, data, length, address.value());
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret == static_cast<ssize_t>(length)) {
+      nwritten = length;
+      error = kSuccess;
+    }
+  }
+
 #if defined(HAVE_PROCESS_VM_WRITEV)
-  // See comment in Process::readMemory.
-  if (length > sizeof(uintptr_t)) {
+  // See comment in Process::fetchMemory.
+  if (error != kSuccess && length > sizeof(uintptr_t)) {
     struct iovec local_iov = {const_cast<void *>(data), length};
     struct iovec remote_iov = {reinterpret_cast<void *>(address.value()),
                                length};
-    auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
 
     ssize_t ret = process_vm_writev(id, &local_iov, 1, &remote_iov, 1, 0);
     if (ret >= 0) {
-      if (count != nullptr) {
-        *count = ret;
-      }
-      return kSuccess;
+      nwritten = ret;
+      error = kSuccess;
     }
   }
 #endif
 
-  // Fallback to super::writeMemory, which uses ptrace(2).
-  return super::writeMemory(address, data, length, count);
+  // Fallback to ptrace(2).
+  if (error != kSuccess) {
+    error = ptrace().writeMemory(id, address, data, length, &nwritten);
+  }
+
+  // The cache has to see the bytes we wrote before the breakpoint manager
+  // gets a chance to put opcodes back over them.
+  _memoryCache.update(address, data, nwritten);
+  softwareBreakpointManager()->updateMemory(address, data, nwritten);
+
+  if (count != nullptr) {
+    *count = nwritten;
+  }
+  return error;
 }
 
 ErrorCode Process::checkMemoryErrorCode(uint64_t address) {
@@ -172,47 +403,73 @@ ErrorCode Process::checkMemoryErrorCode(uint64_t address) {
 }
 
 ErrorCode Process::wait() {
-  int status, signal;
+  int status = 0, signal;
   bool stepping;
   ProcessInfo info;
-  ThreadId tid;
+  ThreadId tid = 0;
 
   // We have at least one thread when we start waiting on a process.
   DS2ASSERT(!_threads.empty());
 
   do {
-    tid = blocking_waitpid(-1, &status, __WALL);
-    if (tid <= 0) {
-      return kErrorProcessNotFound;
-    }
-
-    DS2LOG(Debug, "tid %" PRI_PID " %s", tid, Stringify::WaitStatus(status));
-
-    auto threadIt = _threads.find(tid);
-    if (super::checkInterrupt(tid, status)) {
-      DS2ASSERT(threadIt == _threads.end());
-      // We were explicitly interrupted. In this scenario, check the state of
-      // all threads and resume a stopped one if none is running.
-      bool running = false;
-      Thread* stoppedThread = nullptr;
+    if (_events.interrupted.exchange(false)) {
+      // We were explicitly interrupted (see Process::interrupt). Interrupt a
+      // running thread, the main one if possible, and report its
+      // PTRACE_EVENT_STOP as the interrupt. If no thread is running, report a
+      // stopped one right away.
+      std::vector<Thread *> running;
+      Thread *stoppedThread = nullptr;
       enumerateThreads([&](Thread *thread) {
-        if (stoppedThread == nullptr && thread->state() == Thread::kStopped)
+        if (thread->state() == Thread::kRunning ||
+            thread->state() == Thread::kStepped) {
+          if (thread->tid() == _pid)
+            running.insert(running.begin(), thread);
+          else
+            running.push_back(thread);
+        } else if (stoppedThread == nullptr &&
+                   thread->state() == Thread::kStopped) {
           stoppedThread = thread;
-        else if (thread->state() == Thread::kRunning)
-          running = true;
+        }
       });
 
-      if (!running && stoppedThread != nullptr) {
-        DS2LOG(Debug, "interrupted by %" PRI_PID "; resuming %" PRI_PID,
-               tid, stoppedThread->tid());
-        CHK(stoppedThread->resume());
+      Thread *interruptedThread = nullptr;
+      for (auto thread : running) {
+        thread->_interruptReason = StopInfo::kReasonSignalStop;
+        if (ptrace().suspend(ProcessThreadId(_pid, thread->tid())) ==
+            kSuccess) {
+          interruptedThread = thread;
+          break;
+        }
+        thread->_interruptReason = StopInfo::kReasonNone;
+      }
+
+      if (interruptedThread != nullptr) {
+        DS2LOG(Debug, "interrupted; interrupting %" PRI_PID,
+               interruptedThread->tid());
+      } else if (stoppedThread != nullptr) {
+        DS2LOG(Debug, "interrupted; reporting %" PRI_PID,
+               stoppedThread->tid());
+        _currentThread = stoppedThread;
+        _currentThread->_stopInfo.clear();
+        _currentThread->_stopInfo.event = StopInfo::kEventStop;
+        _currentThread->_stopInfo.reason = StopInfo::kReasonSignalStop;
+        _currentThread->_stopInfo.signal = SIGSTOP;
+        break;
       } else {
-        DS2LOG(Debug, "interrupted by %" PRI_PID "; cleared and ignored", tid);
+        DS2LOG(Debug, "interrupted; cleared and ignored");
       }
+    }
 
-      goto continue_waiting;
+    tid = waitForEvent(&status);
+    if (tid == 0) {
+      continue;
+    } else if (tid < 0) {
+      return kErrorProcessNotFound;
     }
 
+    DS2LOG(Debug, "tid %" PRI_PID " %s", tid, Stringify::WaitStatus(status));
+
+    auto threadIt = _threads.find(tid);
     if (threadIt == _threads.end()) {
       // If we don't know about this thread yet, but it has a WIFEXITED() or a
       // WIFSIGNALED() status (i.e.: it terminated), it means we already
@@ -368,14 +625,60 @@ ErrorCode Process::wait() {
   return kSuccess;
 }
 
+ErrorCode Process::suspend() {
+  //
+  // Ask every running thread to stop before waiting for any of them, so that
+  // stopping all of them costs a single round of waiting rather than one per
+  // thread. Threads that couldn't be interrupted are left to the generic
+  // implementation, which also cleans up the ones that went away.
+  //
+  std::vector<Thread *> interrupted;
+  enumerateThreads([&](Thread *thread) {
+    if (thread->state() != Thread::kRunning)
+      return;
+
+    // The thread may have stopped on its own since we last resumed it (see
+    // Thread::suspend).
+    int status;
+    if (::waitpid(thread->tid(), &status, __WALL | WNOHANG) == thread->tid()) {
+      thread->updateStopInfo(status);
+      return;
+    }
+
+    if (ptrace().suspend(ProcessThreadId(_pid, thread->tid())) == kSuccess) {
+      interrupted.push_back(thread);
+    }
+  });
+
+  for (auto thread : interrupted) {
+    int status;
+    if (ptrace().wait(ProcessThreadId(_pid, thread->tid()), &status) ==
+        kSuccess) {
+      thread->updateStopInfo(status);
+    }
+  }
+
+  return super::suspend();
+}
+
 ErrorCode Process::interrupt() {
-  // Unconditionally send an interrupt here even if sending kill(STOP) to the
-  // inferior will generate waitpid() events. Because this method can be called
-  // off of the main thread, it is potentially unsafe to inspect process state
-  // here. Instead, state is inspected on receipt of the interrupt in
-  // Linux::Process:wait(), which will ignore any unnecessary interrupts.
-  CHK(super::sendInterrupt());
-  return super::interrupt();
+  // This method is usually called from the event loop while wait() runs it,
+  // but may be called off of the main thread, which is the only one allowed
+  // to make ptrace(2) requests on the inferior. Only flag the interrupt and
+  // wake up waitForEvent() here; Linux::Process::wait() interrupts the
+  // inferior with PTRACE_INTERRUPT when it sees the flag, and ignores any
+  // unnecessary interrupts. There can be only one pending interrupt at a
+  // time.
+  if (_events.interrupted.exchange(true))
+    return kSuccess;
+
+  uint64_t value = 1;
+  if (_events.interrupt >= 0 &&
+      ::write(_events.interrupt, &value, sizeof(value)) < 0) {
+    return Platform::TranslateError();
+  }
+
+  return kSuccess;
 }
 
 ErrorCode Process::terminate() {
@@ -453,6 +756,13 @@ ErrorCode Process::updateAuxiliaryVector() {
 }
 
 ErrorCode Process::updateInfo() {
+  //
+  // The information only goes stale on exec, which invalidates it.
+  //
+  if (_info.pid == _pid) {
+    return kErrorAlreadyExist;
+  }
+
   //
   // Some info like parent pid, OS vendor, etc is obtained via /proc.
   //
@@ -469,23 +779,37 @@ ErrorCode Process::updateInfo() {
   return kSuccess;
 }
 
-ErrorCode Process::getMemoryRegionInfo(Address const &address,
-                                       MemoryRegionInfo &info) {
-  if (!address.valid()) {
-    return kErrorInvalidArgument;
+ErrorCode Process::refreshInfo() {
+  pid_t ppid;
+  uid_t uid, euid;
+  gid_t gid, egid;
+
+  if (!ProcFS::ReadProcessIds(_pid, ppid, uid, euid, gid, egid)) {
+    return kErrorProcessNotFound;
   }
 
-  info.clear();
+  _info.parentPid = ppid;
+  _info.realUid = uid;
+  _info.effectiveUid = euid;
+  _info.realGid = gid;
+  _info.effectiveGid = egid;
+
+  return kSuccess;
+}
+
+ErrorCode Process::updateMemoryMap() {
+  if (_memoryMap.valid) {
+    return kSuccess;
+  }
 
   FILE *fp = ProcFS::OpenFILE(_pid, "maps");
   if (fp == nullptr) {
     return Platform::TranslateError();
   }
 
-  uint64_t last = 0;
-  bool found = false;
+  _memoryMap.regions.clear();
 
-  while (!found) {
+  for (;;) {
     // Each line can contain one path and some additional addresses and
     // such, so PATH_MAX * 2 should be enough.
     char buf[PATH_MAX * 2];
@@ -502,7 +826,10 @@ ErrorCode Process::getMemoryRegionInfo(Address const &address,
         break;
       } else {
         DS2ASSERT(errno != 0);
-        return Platform::TranslateError();
+        ErrorCode error = Platform::TranslateError();
+        std::fclose(fp);
+        _memoryMap.regions.clear();
+        return error;
       }
     }
 
@@ -514,57 +841,88 @@ ErrorCode Process::getMemoryRegionInfo(Address const &address,
       continue;
     }
 
-    if (address >= last && address < start) {
-      //
-      // A hole.
-      //
-      info.start = last;
-      info.length = start - last;
-      info.name = name;
-      found = true;
-    } else if (address >= start && address < end) {
+    MemoryRegionInfo region;
+    region.start = start;
+    region.length = end - start;
+    if (r == 'r')
+      region.protection |= ds2::kProtectionRead;
+    if (w == 'w')
+      region.protection |= ds2::kProtectionWrite;
+    if (x == 'x')
+      region.protection |= ds2::kProtectionExecute;
+    while (buf[nread] != '\0' && std::isspace(buf[nread]))
+      ++nread;
+    region.name = name;
+    region.backingFile = buf + nread;
+    region.backingFileOffset = offset;
+    region.backingFileInode = inode;
+    _memoryMap.regions.push_back(std::move(region));
+  }
+  std::fclose(fp);
+
+  // The kernel lists mappings in address order, which is what lookups rely
+  // on.
+  _memoryMap.valid = true;
+  return kSuccess;
+}
+
+void Process::invalidateMemoryCache() {
+  super::invalidateMemoryCache();
+  _memoryMap.valid = false;
+}
+
+ErrorCode Process::getMemoryRegionInfo(Address const &address,
+                                       MemoryRegionInfo &info) {
+  if (!address.valid()) {
+    return kErrorInvalidArgument;
+  }
+
+  info.clear();
+
+  CHK(updateMemoryMap());
+
+  auto const &regions = _memoryMap.regions;
+  auto it = std::upper_bound(regions.begin(), regions.end(), address.value(),
+                             [](uint64_t value, MemoryRegionInfo const &region) {
+                               return value < region.start.value();
+                             });
+
+  uint64_t last = 0;
+  if (it != regions.begin()) {
+    auto const &prev = *(it - 1);
+    if (address.value() < prev.start.value() + prev.length) {
       //
       // A defined region.
       //
-      info.start = start;
-      info.length = end - start;
-      info.protection = 0;
-      if (r == 'r')
-        info.protection |= ds2::kProtectionRead;
-      if (w == 'w')
-        info.protection |= ds2::kProtectionWrite;
-      if (x == 'x')
-        info.protection |= ds2::kProtectionExecute;
-      while (buf[nread] != '\0' && std::isspace(buf[nread]))
-        ++nread;
-      info.name = name;
-      info.backingFile = buf + nread;
-      info.backingFileOffset = offset;
-      info.backingFileInode = inode;
-      found = true;
-    } else {
-      last = end;
+      info = prev;
+      return kSuccess;
     }
+    last = prev.start.value() + prev.length;
   }
-  std::fclose(fp);
-
-  if (!found) {
-    info.start = last;
 
+  info.start = last;
+  if (it != regions.end()) {
     //
-    // We need to obtain the end of the address space, first
-    // we need to know if it's 64-bit.
+    // A hole.
     //
-    ErrorCode error = updateInfo();
-    if (error != kSuccess && error != kErrorAlreadyExist) {
-      return error;
-    }
+    info.length = it->start.value() - last;
+    info.name = it->name;
+    return kSuccess;
+  }
 
-    if (CPUTypeIs64Bit(_info.cpuType)) {
-      info.length = std::numeric_limits<uint64_t>::max() - info.start;
-    } else {
-      info.length = std::numeric_limits<uint32_t>::max() - info.start;
-    }
+  //
+  // We need to obtain the end of the address space, first
+  // we need to know if it's 64-bit.
+  //
+  ErrorCode error = updateInfo();
+  if (error != kSuccess && error != kErrorAlreadyExist) {
+    return error;
+  }
+
+  if (CPUTypeIs64Bit(_info.cpuType)) {
+    info.length = std::numeric_limits<uint64_t>::max() - info.start;
+  } else {
+    info.length = std::numeric_limits<uint32_t>::max() - info.start;
   }
 
   return kSuccess;
@@ -573,7 +931,11 @@ ErrorCode Process::getMemoryRegionInfo(Address const &address,
 ErrorCode Process::executeCode(ByteVector const &codestr, uint64_t &result) {
   ProcessInfo info;
 
+  // ptrace().execute() saves and restores the registers it finds in the
+  // thread, so pending register writes have to land there first.
+  CHK(_currentThread->flushCPUState());
   CHK(getInfo(info));
+  invalidateMemoryCache();
   CHK(ptrace().execute(_currentThread->tid(), info, &codestr[0], codestr.size(),
                        result));
 
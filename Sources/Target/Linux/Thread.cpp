@@ -33,8 +33,27 @@ namespace Linux {
 
 Thread::Thread(Process *process, ThreadId tid) : super(process, tid) {}
 
+// Stops that put the whole process in a group-stop (job control).
+static bool IsStopSignal(int signal) {
+  switch (signal) {
+  case SIGSTOP:
+  case SIGTSTP:
+  case SIGTTIN:
+  case SIGTTOU:
+    return true;
+  default:
+    return false;
+  }
+}
+
 ErrorCode Thread::updateStopInfo(int waitStatus) {
   super::updateStopInfo(waitStatus);
+  _procStateFresh = false;
+
+  // Whatever we asked for is satisfied by the first stop, the kernel drops a
+  // pending PTRACE_INTERRUPT when the tracee traps for any other reason.
+  StopInfo::Reason interruptReason = _interruptReason;
+  _interruptReason = StopInfo::kReasonNone;
 
   switch (_stopInfo.event) {
   case StopInfo::kEventExit:
@@ -66,20 +85,43 @@ ErrorCode Thread::updateStopInfo(int waitStatus) {
     // (1c) a thread that vfork(2)'d resumes after its child calls execve(2)
     //      or _exit(2) and stops sharing memory with it, reported via
     //      PTRACE_EVENT_VFORK_DONE the same way as (1)/(1b);
-    // (2) we sent the thread a SIGSTOP (with tkill(2)) to suspend it e.g.:
-    //     when a thread hits a breakpoint, we have to stop every other thread,
-    //     so we send each one of them a SIGSTOP with tkill(2). These other
-    //     treads will be marked as stopped for no reason so the debugger can
-    //     adapt its output (e.g.: lldb will simply hide these threads and only
-    //     display the one that stopped for a breakpoint);
-    // (3) we sent the process a SIGSTOP (with kill(2)) to interrupt it
-    //     entirely. This happens when the user hits Ctrl-C and the debugger
-    //     sends us a "\x03" for instance;
-    // (4) the inferior received a SIGSTOP because of ptrace attach. We have to
-    //     mark the thread as stopped for a trap;
-    // (5) the inferior received a SIGTRAP. This is usually because of a
+    // (1d) the inferior called execve(2), reported via PTRACE_EVENT_EXEC
+    //      the same way as (1). Everything we know about the old image is
+    //      stale; the stop itself is reported as a trap, which is what the
+    //      kernel's legacy post-exec SIGTRAP used to be reported as;
+    // (2) the thread reported a PTRACE_EVENT_STOP, which happens when:
+    //     (2a) we interrupted it (with PTRACE_INTERRUPT) to suspend it e.g.:
+    //          when a thread hits a breakpoint, we have to stop every other
+    //          thread. These other threads will be marked as stopped for no
+    //          reason so the debugger can adapt its output (e.g.: lldb will
+    //          simply hide these threads and only display the one that
+    //          stopped for a breakpoint);
+    //     (2b) we interrupted it on behalf of the debugger, when the user
+    //          hits Ctrl-C or when attaching, in which case the stop is
+    //          reported with the reason we were given (see Process::wait and
+    //          Process::attach);
+    //     (2c) the process entered a group-stop (e.g. SIGSTOP or SIGTSTP
+    //          were delivered), the thread is then restarted with
+    //          PTRACE_LISTEN so that it stays stopped until SIGCONT, at
+    //          which point it reports another PTRACE_EVENT_STOP;
+    // (3) the inferior received a SIGTRAP. This is usually because of a
     //     breakpoint, single step or such;
 
+    if ((waitStatus >> 16) == PTRACE_EVENT_STOP) { // (2)
+      _groupStopped = IsStopSignal(_stopInfo.signal);
+      if (interruptReason != StopInfo::kReasonNone) { // (2b)
+        _stopInfo.reason = interruptReason;
+        if (!_groupStopped) {
+          _stopInfo.signal = SIGSTOP;
+        }
+      } else { // (2a), (2c)
+        _stopInfo.event = StopInfo::kEventNone;
+      }
+      break;
+    }
+
+    _groupStopped = false;
+
     siginfo_t si;
     ProcessThreadId ptid(process()->pid(), tid());
     ErrorCode error = process()->ptrace().getSigInfo(ptid, si);
@@ -94,6 +136,7 @@ ErrorCode Thread::updateStopInfo(int waitStatus) {
     static constexpr int kEventVFork = SIGTRAP | (PTRACE_EVENT_VFORK << 8);
     static constexpr int kEventVForkDone =
         SIGTRAP | (PTRACE_EVENT_VFORK_DONE << 8);
+    static constexpr int kEventExec = SIGTRAP | (PTRACE_EVENT_EXEC << 8);
     const int waitStatusHi = waitStatus >> 8;
 
     if (waitStatusHi == kEventClone) { // (1)
@@ -164,17 +207,12 @@ ErrorCode Thread::updateStopInfo(int waitStatus) {
       } else {
         _stopInfo.event = StopInfo::kEventNone;
       }
-    } else if (si.si_code == SI_TKILL && si.si_pid == getpid()) { // (2)
-      // The only signal we are supposed to send to the inferior is a SIGSTOP.
-      DS2ASSERT(_stopInfo.signal == SIGSTOP);
-      _stopInfo.event = StopInfo::kEventNone;
-    } else if (si.si_code == SI_USER && si.si_pid == getpid()) { // (3)
-      DS2ASSERT(_stopInfo.signal == SIGSTOP);
-      _stopInfo.reason = StopInfo::kReasonSignalStop;
-    } else if (si.si_code == SI_USER && si.si_pid == 0 &&
-               _stopInfo.signal == SIGSTOP) { // (4)
+    } else if (waitStatusHi == kEventExec) { // (1d)
+      process()->invalidateInfo();
+      process()->softwareBreakpointManager()->discardLocations();
+      process()->closeMemoryFile();
       _stopInfo.reason = StopInfo::kReasonTrap;
-    } else if (_stopInfo.signal == SIGTRAP) { // (5)
+    } else if (_stopInfo.signal == SIGTRAP) { // (3)
       switch (si.si_code) {
       case TRAP_HWBKPT:
       case TRAP_TRACE: {
@@ -225,57 +263,85 @@ ErrorCode Thread::updateStopInfo(int waitStatus) {
            Stringify::StopEvent(_stopInfo.event));
   }
 
+  //
+  // If the stop that dropped our PTRACE_INTERRUPT is one we would resume
+  // from transparently (e.g.: a clone event), the interrupt would never show
+  // up; report this stop as the one we asked for instead.
+  //
+  if (interruptReason != StopInfo::kReasonNone &&
+      _stopInfo.event == StopInfo::kEventNone) {
+    _stopInfo.event = StopInfo::kEventStop;
+    _stopInfo.reason = interruptReason;
+    _stopInfo.signal = SIGSTOP;
+  }
+
   return kSuccess;
 }
 
-void Thread::updateState() {
-  if (!process()->isAlive()) {
-    _state = kTerminated;
-    return;
+ErrorCode Thread::resume(int signal, Address const &address) {
+  //
+  // Don't let a thread in group-stop run when the process as a whole is
+  // supposed to be stopped, unless we have a signal to deliver or somewhere
+  // else to go.
+  //
+  if (_groupStopped && _state == kStopped && signal == 0 &&
+      !address.valid()) {
+    CHK(flushCPUState());
+    CHK(process()->ptrace().listen(ProcessThreadId(process()->pid(), tid())));
+    invalidateCPUState();
+    _state = kRunning;
+    return kSuccess;
   }
 
-  ProcFS::Stat stat;
-  if (!ProcFS::ReadStat(_process->pid(), tid(), stat)) {
-    stat.task_cpu = 0;
-    stat.state = 0;
+  return super::resume(signal, address);
+}
+
+ErrorCode Thread::suspend() {
+  //
+  // The thread may have stopped on its own since we last resumed it; reap
+  // that stop rather than queueing a SIGSTOP behind it.
+  //
+  if (_state == kRunning) {
+    int status;
+    if (::waitpid(tid(), &status, __WALL | WNOHANG) == tid())
+      updateStopInfo(status);
   }
 
-  _stopInfo.core = stat.task_cpu;
+  return super::suspend();
+}
 
-  State oldState = _state;
+void Thread::readProcState() const {
+  ProcFS::Stat stat;
+  _core = ProcFS::ReadStat(_process->pid(), tid(), stat)
+              ? static_cast<int>(stat.task_cpu)
+              : -1;
+  _name = ProcFS::GetThreadName(_process->pid(), tid());
+  _procStateFresh = true;
+}
 
-  switch (stat.state) {
-  case Host::Linux::kProcStateZombie:
-  case Host::Linux::kProcStateDead:
-    _state = kTerminated;
-    break;
+std::string Thread::name(bool refresh) const {
+  if ((refresh || _name.empty()) && !_procStateFresh)
+    readProcState();
 
-  case Host::Linux::kProcStateUninterruptible:
-  case Host::Linux::kProcStateSleeping:
-  case Host::Linux::kProcStateRunning:
-  case Host::Linux::kProcStatePaging:
-    _state = kRunning;
-    break;
+  return _name;
+}
 
-  case Host::Linux::kProcStateTraced:
-  case Host::Linux::kProcStateStopped:
-    _state = kStopped;
-    break;
-  default:
-    _state = kInvalid;
-    break;
-  }
+int Thread::core(bool refresh) const {
+  if (refresh && !_procStateFresh)
+    readProcState();
 
-  // If the thread state has gone from running to a non-running state,
-  // update the stop info, to maintain consistentency between
-  // the state and the stop info.
-  if (oldState == kRunning && _state != kRunning) {
-    int status;
-    int ret = ::waitpid(tid(), &status, __WALL | WNOHANG);
-    DS2ASSERT(ret >= 0);
+  return _procStateFresh ? _core : -1;
+}
 
-    updateStopInfo(status);
-  }
+void Thread::updateState() {
+  //
+  // The run state is maintained from the ptrace(2) requests we make and the
+  // wait(2) events we get back (see resume, suspend, updateStopInfo and
+  // Process::wait), so there is nothing to read back from /proc here unless
+  // the whole process went away.
+  //
+  if (process()->_terminated)
+    _state = kTerminated;
 }
 } // namespace Linux
 } // namespace Target
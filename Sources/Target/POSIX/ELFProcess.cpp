@@ -141,6 +141,9 @@ inline ErrorCode GetELFSharedLibraryInfoAddress(ELFProcess *process,
 //   struct link_map *l_next;
 //   struct link_map *l_prev;
 //
+// RT_CONSISTENT, which link.h scopes to struct r_debug.
+static int const kELFDebugStateConsistent = 0;
+
 template <typename T> struct ELFDebug {
   int version;
   T mapAddress;
@@ -169,10 +172,36 @@ inline ErrorCode ReadELFLinkMap(ELFProcess *process, Address address,
   return process->readMemory(address, &linkMap, sizeof(linkMap));
 }
 
+//
+// Whether the entry at `order[index]` still links to the same neighbours and
+// describes the same object as when we last walked the list.
+//
+template <typename T>
+bool LinkMapEntryUnchanged(
+    ELFProcess *process,
+    std::map<uint64_t, ELFProcess::LinkMapEntry> const &entries,
+    std::vector<uint64_t> const &order, size_t index) {
+  ELFLinkMap<T> linkMap;
+  if (ReadELFLinkMap(process, order[index], linkMap) != kSuccess)
+    return false;
+
+  T prevAddress = (index > 0) ? static_cast<T>(order[index - 1]) : 0;
+  T nextAddress =
+      (index + 1 < order.size()) ? static_cast<T>(order[index + 1]) : 0;
+  ELFProcess::LinkMapEntry const &entry = entries.at(order[index]);
+
+  return linkMap.prevAddress == prevAddress &&
+         linkMap.nextAddress == nextAddress &&
+         linkMap.nameAddress == entry.nameAddress &&
+         linkMap.baseAddress == entry.library.svr4.baseAddress &&
+         linkMap.ldAddress == entry.library.svr4.ldAddress;
+}
+
 template <typename T>
-ErrorCode
-EnumerateLinkMap(ELFProcess *process, Address addressToDPtr,
-                 std::function<void(SharedLibraryInfo const &)> const &cb) {
+ErrorCode UpdateLinkMap(ELFProcess *process, Address addressToDPtr,
+                        bool haveModel,
+                        std::map<uint64_t, ELFProcess::LinkMapEntry> &entries,
+                        std::vector<uint64_t> &order) {
   ELFDebug<T> debug;
   ELFLinkMap<T> linkMap;
   T address;
@@ -196,33 +225,68 @@ EnumerateLinkMap(ELFProcess *process, Address addressToDPtr,
   }
 #endif
 
+  // The dynamic linker is in the middle of adding or removing objects; the
+  // list we already have is the last consistent one.
+  if (haveModel && debug.state != kELFDebugStateConsistent) {
+    return kSuccess;
+  }
+
+  //
+  // Objects get appended to the list, so if it still starts and ends where
+  // it did, assume nothing changed rather than walking it on every stop.
+  // This misses an object unloaded from the middle of the list with nothing
+  // loaded since, until the next change at either end.
+  //
+  if (haveModel && !order.empty() && debug.mapAddress == order.front() &&
+      LinkMapEntryUnchanged<T>(process, entries, order, 0) &&
+      LinkMapEntryUnchanged<T>(process, entries, order, order.size() - 1)) {
+    return kSuccess;
+  }
+
+  std::map<uint64_t, ELFProcess::LinkMapEntry> previous;
+  previous.swap(entries);
+  order.clear();
+
   linkMapAddress = debug.mapAddress;
   while (linkMapAddress != 0) {
-    SharedLibraryInfo shlib;
-
     CHK(ReadELFLinkMap(process, linkMapAddress, linkMap));
-    CHK(process->readString(linkMap.nameAddress, shlib.path, PATH_MAX));
 
-    shlib.svr4.mapAddress = linkMapAddress;
-    shlib.svr4.baseAddress = linkMap.baseAddress;
-    shlib.svr4.ldAddress = linkMap.ldAddress;
-    shlib.sections.clear();
+    ELFProcess::LinkMapEntry &entry = entries[linkMapAddress];
+    SharedLibraryInfo &shlib = entry.library;
+
+    //
+    // Reading the name is the expensive part of this walk; reuse the one we
+    // got last time if this is still the same object.
+    //
+    auto it = previous.find(linkMapAddress);
+    if (it != previous.end() && it->second.nameAddress == linkMap.nameAddress &&
+        it->second.library.svr4.baseAddress == linkMap.baseAddress &&
+        it->second.library.svr4.ldAddress == linkMap.ldAddress) {
+      entry = std::move(it->second);
+    } else {
+      CHK(process->readString(linkMap.nameAddress, shlib.path, PATH_MAX));
+
+      entry.nameAddress = linkMap.nameAddress;
+      shlib.svr4.mapAddress = linkMapAddress;
+      shlib.svr4.baseAddress = linkMap.baseAddress;
+      shlib.svr4.ldAddress = linkMap.ldAddress;
+      shlib.sections.clear();
 
 #if defined(OS_LINUX) && !defined(PLATFORM_ANDROID)
-    // On non-android linux systems, main executable has an empty path.
-    shlib.main = shlib.path.empty();
+      // On non-android linux systems, main executable has an empty path.
+      shlib.main = shlib.path.empty();
 #elif defined(OS_LINUX) && defined(PLATFORM_ANDROID)
-    // On android, the main executable has a load address of 0.
-    shlib.main = shlib.svr4.ldAddress == 0;
+      // On android, the main executable has a load address of 0.
+      shlib.main = shlib.svr4.ldAddress == 0;
 #elif defined(OS_FREEBSD)
-    // FIXME(sas): not sure how exactly to determine this on FreeBSD.
-    shlib.main = false;
+      // FIXME(sas): not sure how exactly to determine this on FreeBSD.
+      shlib.main = false;
 #else
 #error "Target not supported."
 #endif
+    }
 
-    cb(shlib);
-
+    order.push_back(linkMapAddress);
     linkMapAddress = linkMap.nextAddress;
   }
 
@@ -240,20 +304,27 @@ ErrorCode ELFProcess::getAuxiliaryVector(std::string &auxv) {
 }
 
 uint64_t ELFProcess::getAuxiliaryVectorValue(uint64_t type) {
-  uint64_t value = 0;
-  bool found = false;
+  bool is64Bit = CPUTypeIs64Bit(_info.cpuType);
 
-  enumerateAuxiliaryVector([&](ELFSupport::AuxiliaryVectorEntry const &entry) {
-    if (found)
-      return;
+  if (!_auxiliaryVectorTable.valid || _auxiliaryVectorTable.is64Bit != is64Bit) {
+    _auxiliaryVectorTable.values.clear();
 
-    if (entry.type == type) {
-      value = entry.value;
-      found = true;
+    ErrorCode error = enumerateAuxiliaryVector(
+        [this](ELFSupport::AuxiliaryVectorEntry const &entry) {
+          // The first entry of a given type wins.
+          _auxiliaryVectorTable.values.emplace(entry.type, entry.value);
+        });
+    if (error != kSuccess) {
+      _auxiliaryVectorTable.values.clear();
+      return 0;
     }
-  });
 
-  return value;
+    _auxiliaryVectorTable.valid = true;
+    _auxiliaryVectorTable.is64Bit = is64Bit;
+  }
+
+  auto it = _auxiliaryVectorTable.values.find(type);
+  return (it == _auxiliaryVectorTable.values.end()) ? 0 : it->second;
 }
 
 //
@@ -421,6 +492,24 @@ ErrorCode ELFProcess::updateInfo() {
   return kSuccess;
 }
 
+//
+// Everything we derived from the auxiliary vector describes the image the
+// process had when we read it, and goes away when it execs.
+//
+void ELFProcess::invalidateInfo() {
+  super::invalidateInfo();
+
+  _auxiliaryVector.clear();
+  _auxiliaryVectorTable.valid = false;
+  _auxiliaryVectorTable.values.clear();
+  _sharedLibraryInfoAddress.clear();
+  _linkMap.entries.clear();
+  _linkMap.order.clear();
+  _linkMap.valid = false;
+  _loadBase.clear();
+  _entryPoint.clear();
+}
+
 //
 // Inheriting class should call this method and then
 // read data into _auxiliaryVector buffer; if this method
@@ -429,10 +518,8 @@ ErrorCode ELFProcess::updateInfo() {
 // successful, any other error should be ignored.
 //
 ErrorCode ELFProcess::updateAuxiliaryVector() {
-#if 0
-    if (!_auxiliaryVector.empty())
-        return kErrorAlreadyExist;
-#endif
+  if (!_auxiliaryVector.empty())
+    return kErrorAlreadyExist;
 
   return kSuccess;
 }
@@ -500,14 +587,46 @@ ErrorCode ELFProcess::getSharedLibraryInfoAddress(Address &address) {
 //
 ErrorCode ELFProcess::enumerateSharedLibraries(
     std::function<void(SharedLibraryInfo const &)> const &cb) {
+  CHK(updateLinkMap());
+
+  for (uint64_t address : _linkMap.order) {
+    cb(_linkMap.entries[address].library);
+  }
+
+  return kSuccess;
+}
+
+//
+// Brings the link map model up to date with the inferior, at most once per
+// stop.
+//
+ErrorCode ELFProcess::updateLinkMap() {
+  if (_linkMap.valid && _linkMap.generation == stopGeneration()) {
+    return kSuccess;
+  }
+
   Address address;
   CHK(getSharedLibraryInfoAddress(address));
 
+  ErrorCode error;
   if (CPUTypeIs64Bit(_info.cpuType)) {
-    return EnumerateLinkMap<uint64_t>(this, address, cb);
+    error = UpdateLinkMap<uint64_t>(this, address, _linkMap.valid,
+                                    _linkMap.entries, _linkMap.order);
   } else {
-    return EnumerateLinkMap<uint32_t>(this, address, cb);
+    error = UpdateLinkMap<uint32_t>(this, address, _linkMap.valid,
+                                    _linkMap.entries, _linkMap.order);
+  }
+
+  if (error != kSuccess) {
+    _linkMap.entries.clear();
+    _linkMap.order.clear();
+    _linkMap.valid = false;
+    return error;
   }
+
+  _linkMap.generation = stopGeneration();
+  _linkMap.valid = true;
+  return kSuccess;
 }
 } // namespace POSIX
 } // namespace Target
@@ -36,7 +36,11 @@ namespace POSIX {
 ErrorCode Process::initialize(ProcessId pid, uint32_t flags) {
   // Wait the main thread.
   int status;
-  CHK(ptrace().wait(pid, &status));
+  if (flags & kFlagNewProcess) {
+    CHK(ptrace().traceChild(pid, &status));
+  } else {
+    CHK(ptrace().wait(pid, &status));
+  }
   CHK(ptrace().traceThat(pid));
 
   // Can't use `CHK()` here because of a bug in GCC. See
@@ -48,6 +52,10 @@ ErrorCode Process::initialize(ProcessId pid, uint32_t flags) {
 
   CHK(attach(status));
 
+  // Our readMemory() and writeMemory() account for breakpoint opcodes, so
+  // they can stay in memory while the inferior is stopped.
+  softwareBreakpointManager()->setPersistent(true);
+
   return kSuccess;
 }
 
@@ -107,13 +115,26 @@ ErrorCode Process::readString(Address const &address, std::string &str,
 ErrorCode Process::readMemory(Address const &address, void *data, size_t length,
                               size_t *count) {
   auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
-  return ptrace().readMemory(id, address, data, length, count);
+  size_t nread = 0;
+  ErrorCode error = ptrace().readMemory(id, address, data, length, &nread);
+  softwareBreakpointManager()->maskMemory(address, data, nread);
+  if (count != nullptr) {
+    *count = nread;
+  }
+  return error;
 }
 
 ErrorCode Process::writeMemory(Address const &address, void const *data,
                                size_t length, size_t *count) {
   auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
-  return ptrace().writeMemory(id, address, data, length, count);
+  size_t nwritten = 0;
+  ErrorCode error =
+      ptrace().writeMemory(id, address, data, length, &nwritten);
+  softwareBreakpointManager()->updateMemory(address, data, nwritten);
+  if (count != nullptr) {
+    *count = nwritten;
+  }
+  return error;
 }
 
 int Process::convertMemoryProtectionToPOSIX(uint32_t protection) const {
@@ -210,75 +231,6 @@ void Process::setSignalPass(int signo, bool set) {
     _passthruSignals.erase(signo);
   }
 }
-
-// Used to interrupt calls to wait(2), waitpid(2), and waitid(2) that are
-// blocked waiting for inferior process events. Requried in the scenario where
-// the debug server's main thread is blocked waiting for events from an
-// inferior process whose threads are already in a stopped state. E.g.:
-// 1. All threads of the inferior process are in a stopped state.
-// 2. The main thread of the debug server is blocked in a waitpid() call
-//    waiting for an event from the inferior process.
-// 2. The debug server process receives an asynchronous \x03 interrupt packet
-//    from the debugger and attempts to interrupt the inferior by calling
-//    kill(SIGSTOP).
-// 3. The kill(SIGSTOP) call has no effect on the inferior process because
-//    every thread is already stopped.
-// 4. The call to waitpid() remains blocked indefinitely.
-//
-// In this situation, the debug server can use sendInterrupt in the following
-// way to interrupt the waitpid() call:
-// 1. In response to the interrupt packet from the debugger, the debug server
-//    calls sendInterrupt() in addition to kill(SIGSTOP). This call forks a
-//    short-lived child process and saves its pid. The child process
-//    immediately exits, generating a thread exit event.
-// 2. The debug server's main thread now returns from waitpid(). It calls
-//    checkInterrupt() with the results from waitpid(). The call compares the
-//    pid returned by waitpid() with the pid stashed by sendInterrupt(), which
-//    returns true if pid matches the one saved during the last call to
-//    sendInterrupt().
-//
-// NOTE: There can be only one pending interrupt at a time. Subsequent calls
-// to sendInterrupt() without corresponding calls to checkInterrupt() are
-// noops.
-ErrorCode Process::sendInterrupt() {
-  // Mutex guards against concurrent calls to checkInterrupt and sendInterrupt.
-  // It is required to atomically fork the interrupting process and memoize it's
-  // pid in the _pid field.
-  std::lock_guard<std::mutex> lock(_interruptState.mutex);
-  if (_interruptState.pid > 0) // There is already a pending interrupt
-    return kSuccess;
-
-  const ProcessId pid = ::fork();
-  if (pid < 0)
-    return Host::Platform::TranslateError();
-
-  if (pid == 0) {
-    DS2LOG(Debug, "forked process %" PRI_PID " to interrupt waiter",
-           ::getpid());
-    // Exiting the forked thread will wake the waiting parent process with
-    // WIFEXITED status.
-    exit(0);
-  }
-
-  _interruptState.pid = pid;
-  return kSuccess;
-}
-
-bool Process::checkInterrupt(ThreadId tid, int waitStatus) {
-  {
-    std::lock_guard<std::mutex> lock(_interruptState.mutex);
-    if (_interruptState.pid <= 0) // no interrupt
-      return false;
-
-    if (_interruptState.pid != tid || !WIFEXITED(waitStatus)) // tid does not match interrupt
-      return false;
-
-    _interruptState.pid = 0; // clear interrupt
-  }
-
-  DS2LOG(Debug, "received interrupt from process %" PRI_PID, tid);
-  return true;
-}
 } // namespace POSIX
 } // namespace Target
 } // namespace ds2
@@ -30,22 +30,37 @@ Thread::Thread(ds2::Target::Process *process, ThreadId tid)
     : super(process, tid) {}
 
 ErrorCode Thread::readCPUState(Architecture::CPUState &state) {
-  // TODO cache CPU state
-  ProcessInfo info;
+  if (!_cpuStateCache.valid) {
+    ProcessInfo info;
 
-  CHK(_process->getInfo(info));
-  CHK(process()->ptrace().readCPUState(ProcessThreadId(process()->pid(), tid()),
-                                       info, state));
+    CHK(_process->getInfo(info));
+    CHK(process()->ptrace().readCPUState(
+        ProcessThreadId(process()->pid(), tid()), info, _cpuStateCache.state));
+    _cpuStateCache.valid = true;
+  }
 
+  state = _cpuStateCache.state;
   return kSuccess;
 }
 
 ErrorCode Thread::writeCPUState(Architecture::CPUState const &state) {
+  _cpuStateCache.state = state;
+  _cpuStateCache.valid = true;
+  _cpuStateCache.dirty = true;
+  return kSuccess;
+}
+
+ErrorCode Thread::flushCPUState() {
+  if (!_cpuStateCache.dirty) {
+    return kSuccess;
+  }
+
   ProcessInfo info;
 
   CHK(_process->getInfo(info));
   CHK(process()->ptrace().writeCPUState(
-      ProcessThreadId(process()->pid(), tid()), info, state));
+      ProcessThreadId(process()->pid(), tid()), info, _cpuStateCache.state));
+  _cpuStateCache.dirty = false;
 
   return kSuccess;
 }
@@ -108,9 +123,12 @@ ErrorCode Thread::step(int signal, Address const &address) {
   DS2LOG(Debug, "stepping tid %d", tid());
 
   ProcessInfo info;
+  CHK(flushCPUState());
   CHK(process()->getInfo(info));
+  process()->invalidateMemoryCache();
   CHK(process()->ptrace().step(ProcessThreadId(process()->pid(), tid()), info,
                                signal, address));
+  invalidateCPUState();
   _state = kStepped;
   return kSuccess;
 }
@@ -120,9 +138,12 @@ ErrorCode Thread::resume(int signal, Address const &address) {
   if (_state == kStopped || _state == kStepped) {
     ProcessInfo info;
 
+    CHK(flushCPUState());
     CHK(process()->getInfo(info));
+    process()->invalidateMemoryCache();
     CHK(process()->ptrace().resume(ProcessThreadId(process()->pid(), tid()),
                                    info, signal, address));
+    invalidateCPUState();
     _state = kRunning;
     _stopInfo.signal = 0;
   } else if (_state == kTerminated) {
@@ -133,6 +154,15 @@ ErrorCode Thread::resume(int signal, Address const &address) {
 }
 
 ErrorCode Thread::updateStopInfo(int waitStatus) {
+  // Some backends resume threads straight through ptrace() while waiting, so
+  // whatever was cached before this stop can't be trusted anymore. A thread
+  // that went away (e.g. killed while stopped) takes any register write still
+  // pending with it.
+  if (WIFEXITED(waitStatus) || WIFSIGNALED(waitStatus)) {
+    _cpuStateCache.dirty = false;
+  }
+  invalidateCPUState();
+  process()->invalidateMemoryCache();
   _stopInfo.clear();
 
   if (WIFEXITED(waitStatus)) {
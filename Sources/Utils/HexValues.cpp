@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Utils/HexValues.h"
+
+#if defined(__SSE2__) || defined(_M_AMD64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_HEX_SSE2
+#include <emmintrin.h>
+#elif defined(ARCH_ARM64) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define HAVE_HEX_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ds2 {
+
+namespace {
+
+// Both hex digits of every byte value, so that encoding is one lookup.
+struct HexPairTable {
+  char pairs[256][2];
+
+  constexpr HexPairTable() : pairs() {
+    for (int n = 0; n < 256; n++) {
+      pairs[n][0] = "0123456789abcdef"[n >> 4];
+      pairs[n][1] = "0123456789abcdef"[n & 15];
+    }
+  }
+};
+
+constexpr HexPairTable kHexPairTable;
+} // namespace
+
+uint8_t const kHexDigitValues[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+void HexEncode(void const *data, size_t size, char *out) {
+  uint8_t const *in = static_cast<uint8_t const *>(data);
+  size_t n = 0;
+
+#if defined(HAVE_HEX_SSE2)
+  //
+  // Split each byte in nibbles, turn them into digits ('0' + nibble, plus
+  // the distance to 'a' for nibbles above 9) and interleave them back.
+  //
+  __m128i const mask = _mm_set1_epi8(0x0f);
+  __m128i const nine = _mm_set1_epi8(9);
+  __m128i const zero = _mm_set1_epi8('0');
+  __m128i const alpha = _mm_set1_epi8('a' - '0' - 10);
+  auto digits = [&](__m128i nibbles) {
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, nine), alpha);
+    return _mm_add_epi8(_mm_add_epi8(nibbles, zero), letters);
+  };
+
+  for (; n + 16 <= size; n += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + n));
+    __m128i hi = digits(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+    __m128i lo = digits(_mm_and_si128(v, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * n),
+                     _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * n + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+  }
+#elif defined(HAVE_HEX_NEON)
+  uint8x16_t const table = vld1q_u8(
+      reinterpret_cast<uint8_t const *>("0123456789abcdef"));
+  for (; n + 16 <= size; n += 16) {
+    uint8x16_t v = vld1q_u8(in + n);
+    uint8x16x2_t pairs;
+    pairs.val[0] = vqtbl1q_u8(table, vshrq_n_u8(v, 4));
+    pairs.val[1] = vqtbl1q_u8(table, vandq_u8(v, vdupq_n_u8(0x0f)));
+    vst2q_u8(reinterpret_cast<uint8_t *>(out + 2 * n), pairs);
+  }
+#endif
+
+  for (; n < size; n++) {
+    out[2 * n] = kHexPairTable.pairs[in[n]][0];
+    out[2 * n + 1] = kHexPairTable.pairs[in[n]][1];
+  }
+}
+
+size_t HexDecode(char const *str, size_t length, void *out) {
+  uint8_t *bytes = static_cast<uint8_t *>(out);
+  size_t count = length / 2;
+
+  //
+  // Invalid digits map to 0xff, so OR-ing all the digit values together
+  // tells whether any of them was invalid without branching on each one.
+  //
+  uint8_t invalid = 0;
+  for (size_t n = 0; n < count; n++) {
+    uint8_t hi = HexToNibble(str[2 * n]);
+    uint8_t lo = HexToNibble(str[2 * n + 1]);
+    invalid |= hi | lo;
+    bytes[n] = (hi << 4) | lo;
+  }
+
+  if ((invalid & 0xf0) == 0)
+    return count;
+
+  for (size_t n = 0; n < count; n++) {
+    if (HexToNibble(str[2 * n]) == kInvalidHexDigit ||
+        HexToNibble(str[2 * n + 1]) == kInvalidHexDigit)
+      return n;
+  }
+
+  return count;
+}
+} // namespace ds2
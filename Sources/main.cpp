@@ -9,13 +9,19 @@
 //
 
 #include "DebugServer2/Core/BreakpointManager.h"
+#if defined(OS_LINUX)
+#include "DebugServer2/Core/SessionLoop.h"
+#else
 #include "DebugServer2/Core/SessionThread.h"
+#endif
 #include "DebugServer2/GDBRemote/DebugSessionImpl.h"
 #include "DebugServer2/GDBRemote/PlatformSessionImpl.h"
 #include "DebugServer2/GDBRemote/ProtocolHelpers.h"
 #include "DebugServer2/GDBRemote/SlaveSessionImpl.h"
 #include "DebugServer2/Host/Platform.h"
+#if !defined(OS_LINUX)
 #include "DebugServer2/Host/QueueChannel.h"
+#endif
 #include "DebugServer2/Host/Socket.h"
 #if defined(OS_POSIX)
 #include "DebugServer2/Host/POSIX/HandleChannel.h"
@@ -53,13 +59,17 @@ using ds2::GDBRemote::Session;
 using ds2::GDBRemote::SessionDelegate;
 using ds2::GDBRemote::SlaveSessionImpl;
 using ds2::Host::Platform;
+#if !defined(OS_LINUX)
 using ds2::Host::QueueChannel;
+#endif
 using ds2::Host::Socket;
 
 static std::string gDefaultPort = "12345";
 static std::string gDefaultHost = "127.0.0.1";
 static bool gDaemonize = false;
 static bool gGDBCompat = false;
+static size_t gPacketSize = ds2::GDBRemote::kDefaultMaxPacketSize;
+static bool gLowLatency = false;
 
 #if defined(OS_POSIX)
 static void CloseFD() {
@@ -210,13 +220,39 @@ static std::unique_ptr<Socket> CreateSocket(std::string const &arg,
   DS2_UNREACHABLE();
 }
 
+// Applies the transport options given on the command line to a connected
+// socket.
+static void SetupConnection(Socket *socket) {
+  if (socket == nullptr || !gLowLatency)
+    return;
+
+  //
+  // Make room in the socket buffers for a few packets of the largest size
+  // we negotiate.
+  //
+  if (!socket->setLowLatency(4 * gPacketSize)) {
+    DS2LOG(Warning, "cannot set all low latency options on connection");
+  }
+}
+
 static int RunDebugServer(ds2::Host::Channel *channel, SessionDelegate *impl) {
   Session session(gGDBCompat ? ds2::GDBRemote::kCompatibilityModeGDB
                              : ds2::GDBRemote::kCompatibilityModeLLDB);
-  QueueChannel qchannel(channel);
-  SessionThread thread(&qchannel, &session);
 
+  session.setMaxPacketSize(gPacketSize);
   session.setDelegate(impl);
+
+#if defined(OS_LINUX)
+  // Everything runs on this thread, from the event loop.
+  SessionLoop loop(channel, &session);
+  session.create(channel);
+
+  DS2LOG(Debug, "Debug session starting");
+  loop.run();
+  DS2LOG(Debug, "Debug session ended");
+#else
+  QueueChannel qchannel(channel);
+  SessionThread thread(&qchannel, &session);
   session.create(&qchannel);
 
   DS2LOG(Debug, "Debug session starting");
@@ -224,6 +260,7 @@ static int RunDebugServer(ds2::Host::Channel *channel, SessionDelegate *impl) {
   while (session.receive(/*cooked=*/true))
     continue;
   DS2LOG(Debug, "Debug session ended");
+#endif
 
   return EXIT_SUCCESS;
 }
@@ -237,6 +274,10 @@ static void AddSharedOptions(ds2::OptParse &opts) {
                  "enable debug log output");
   opts.addOption(ds2::OptParse::boolOption, "no-colors", 'n',
                  "disable colored output");
+  opts.addOption(ds2::OptParse::stringOption, "packet-size", 'P',
+                 "largest packet to send or accept, in bytes");
+  opts.addOption(ds2::OptParse::boolOption, "low-latency", 'L',
+                 "tune the connection for round-trip time over throughput");
 
 #if defined(OS_POSIX)
   opts.addOption(ds2::OptParse::boolOption, "daemonize", 'f',
@@ -263,6 +304,16 @@ static void HandleSharedOptions(ds2::OptParse const &opts) {
     ds2::SetLogColorsEnabled(false);
   }
 
+  if (std::string const &arg = opts.getString("packet-size"); !arg.empty()) {
+    gPacketSize = std::strtoul(arg.c_str(), nullptr, 0);
+    if (gPacketSize < ds2::GDBRemote::kMinPacketSize) {
+      DS2LOG(Fatal, "invalid packet size %s, must be at least %zu bytes",
+             arg.c_str(), ds2::GDBRemote::kMinPacketSize);
+    }
+  }
+
+  gLowLatency = opts.getBool("low-latency");
+
 #if defined(OS_POSIX)
   gDaemonize = opts.getBool("daemonize");
 
@@ -485,11 +536,11 @@ static int GdbserverMain(int argc, char **argv) {
   case channel_type::file_descriptor:
   case channel_type::named_pipe:
   case channel_type::network:
-    if (fd >= 0 || reverse) {
-      channel.reset(socket.release());
-    } else {
-      channel = socket->accept();
+    if (fd < 0 && !reverse) {
+      socket = socket->accept();
     }
+    SetupConnection(socket.get());
+    channel = std::move(socket);
     break;
   case channel_type::character_device:
 #if defined(OS_POSIX)
@@ -538,6 +589,7 @@ static int PlatformMain(int argc, char **argv) {
     PlatformClient(std::unique_ptr<Socket> socket_)
         : socket(std::move(socket_)),
           session(ds2::GDBRemote::kCompatibilityModeLLDB) {
+      session.setMaxPacketSize(gPacketSize);
       session.setDelegate(&impl);
       session.create(socket.get());
     }
@@ -552,6 +604,7 @@ static int PlatformMain(int argc, char **argv) {
 
   do {
     std::unique_ptr<Socket> clientSocket = serverSocket->accept();
+    SetupConnection(clientSocket.get());
     auto platformClient =
         std::make_unique<PlatformClient>(std::move(clientSocket));
 
@@ -626,6 +679,7 @@ static int SlaveMain(int argc, char **argv) {
 
     auto client = std::make_unique<Socket>(clientHandle);
     client->setNonBlocking();
+    SetupConnection(client.get());
 
     SlaveSessionImpl impl;
     return RunDebugServer(client.get(), &impl);
@@ -653,6 +707,12 @@ static int SlaveMain(int argc, char **argv) {
     args.push_back("--log-file");
     args.push_back(opts.getString("log-file"));
   }
+  if (opts.getBool("low-latency"))
+    args.push_back("--low-latency");
+  if (!opts.getString("packet-size").empty()) {
+    args.push_back("--packet-size");
+    args.push_back(opts.getString("packet-size"));
+  }
   args.push_back("--child-socket");
   args.push_back(ds2::Utils::ToString(static_cast<uint64_t>(listenHandle)));
 
@@ -734,6 +794,7 @@ static int SlaveMain(int argc, char **argv) {
     open("/dev/null", O_WRONLY);
 
     std::unique_ptr<Socket> client = server->accept();
+    SetupConnection(client.get());
 
     SlaveSessionImpl impl;
     return RunDebugServer(client.get(), &impl);
@@ -122,7 +122,7 @@ class client:
         wire_packet = frame_packet(packet)
         if self.trace:
             print("<%4u> send packet: %s" % (len(wire_packet), wire_packet))
-        self._socket.send(wire_packet)
+        self._socket.send(wire_packet.encode('latin-1'))
         if get_response:
             if self._shouldSendAck:
                 ack = self.receive_response()
@@ -234,10 +234,16 @@ class client:
 
 def main():
     args = sys.argv[1:]
+    if len(args) < 1:
+        print('usage: %s port [--ack]' % sys.argv[0])
+        sys.exit(1)
     port = int(args[0])
     gdbremote = client()
     gdbremote.connect_to_host(port=port)
-    gdbremote.send_QStartNoAckMode()
+    # Staying in ack mode measures the cost of acknowledgements as well,
+    # which is how most high latency links are used.
+    if '--ack' not in args[1:]:
+        gdbremote.send_QStartNoAckMode()
     num_packets = 1000
     send_sizes = [0, 32, 512, 1024]
     recv_sizes = [0, 32, 512, 1024]
@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/GDBRemote/ProtocolHelpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+using ds2::GDBRemote::Checksum;
+using ds2::GDBRemote::Escape;
+using ds2::GDBRemote::EscapedPrefixLength;
+using ds2::GDBRemote::FindEscapableOrRun;
+using ds2::GDBRemote::Unescape;
+
+namespace {
+
+//
+// Reference implementations, one byte at a time.
+//
+
+bool IsEscapable(char c) {
+  return c == '$' || c == '#' || c == '}' || c == '*';
+}
+
+uint8_t ReferenceChecksum(std::string_view data) {
+  uint8_t csum = 0;
+  for (char c : data) {
+    csum += static_cast<uint8_t>(c);
+  }
+  return csum;
+}
+
+size_t ReferenceFind(std::string_view data, size_t offset, bool runs) {
+  for (; offset < data.size(); offset++) {
+    if (IsEscapable(data[offset]))
+      break;
+    if (runs && offset + 1 < data.size() && data[offset] == data[offset + 1])
+      break;
+  }
+  return offset;
+}
+
+size_t ReferencePrefixLength(std::string_view data, size_t budget) {
+  size_t used = 0;
+  size_t n = 0;
+  for (; n < data.size(); n++) {
+    size_t cost = IsEscapable(data[n]) ? 2 : 1;
+    if (used + cost > budget)
+      break;
+    used += cost;
+  }
+  return n;
+}
+
+std::string ReferenceEscape(std::string_view data) {
+  std::string out;
+  for (char c : data) {
+    if (IsEscapable(c)) {
+      out += '}';
+      out += static_cast<char>(c ^ 0x20);
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+std::mt19937 sRandom(0x64733262);
+unsigned sFailures = 0;
+
+// Bytes with no escapable characters and no two equal neighbours, so that
+// the only hits are the ones a test plants.
+std::string Filler(size_t size) {
+  std::string data;
+  while (data.size() < size) {
+    char c = static_cast<char>(sRandom());
+    if (IsEscapable(c) || (!data.empty() && data.back() == c))
+      continue;
+    data += c;
+  }
+  return data;
+}
+
+// Random bytes drawn mostly from a tiny alphabet, to get plenty of both.
+std::string Dense(size_t size) {
+  static char const kAlphabet[] = "$#}*aab";
+  std::string data;
+  for (size_t n = 0; n < size; n++) {
+    data += (sRandom() % 4 == 0) ? static_cast<char>(sRandom())
+                                 : kAlphabet[sRandom() % 7];
+  }
+  return data;
+}
+
+void Fail(char const *what, std::string_view data, size_t arg, size_t got,
+          size_t expected) {
+  if (sFailures++ < 20) {
+    fprintf(stderr, "%s: size=%zu arg=%zu got=%zu expected=%zu\n", what,
+            data.size(), arg, got, expected);
+  }
+}
+
+void CheckFind(std::string_view data) {
+  for (bool runs : {false, true}) {
+    for (size_t offset = 0; offset <= data.size(); offset++) {
+      size_t got = FindEscapableOrRun(data, offset, runs);
+      size_t expected = ReferenceFind(data, offset, runs);
+      if (got != expected) {
+        Fail(runs ? "FindEscapableOrRun(runs)" : "FindEscapableOrRun", data,
+             offset, got, expected);
+      }
+    }
+  }
+}
+
+void CheckAll(std::string_view data) {
+  if (Checksum(data) != ReferenceChecksum(data)) {
+    Fail("Checksum", data, 0, Checksum(data), ReferenceChecksum(data));
+  }
+
+  CheckFind(data);
+
+  for (size_t budget = 0; budget <= data.size() * 2 + 2; budget++) {
+    size_t got = EscapedPrefixLength(data, budget);
+    size_t expected = ReferencePrefixLength(data, budget);
+    if (got != expected) {
+      Fail("EscapedPrefixLength", data, budget, got, expected);
+    }
+  }
+
+  std::string escaped = Escape(data);
+  if (escaped != ReferenceEscape(data)) {
+    Fail("Escape", data, 0, escaped.size(), ReferenceEscape(data).size());
+  }
+  if (Unescape(escaped) != data) {
+    Fail("Unescape", data, 0, Unescape(escaped).size(), data.size());
+  }
+}
+
+void Check() {
+  // Every length up to a few vectors, and either side of four, starting at
+  // every alignment within a vector.
+  std::string buffer = Filler(256);
+  for (size_t size = 0; size <= 65; size = (size == 40) ? 63 : size + 1) {
+    for (size_t start = 0; start < 16; start++) {
+      std::string_view data(buffer.data() + start, size);
+      CheckAll(data);
+
+      // A single escapable byte or run at each position.
+      for (size_t n = 0; n < size; n++) {
+        std::string planted(data);
+        planted[n] = "$#}*"[n % 4];
+        CheckAll(std::string_view(planted));
+
+        if (n + 1 < size) {
+          planted = std::string(data);
+          planted[n + 1] = planted[n];
+          CheckFind(std::string_view(planted));
+        }
+      }
+    }
+  }
+
+  // Checksum lanes wrap, so sum enough high bytes to overflow every lane many
+  // times over.
+  for (size_t size : {255u, 256u, 4096u, 65537u}) {
+    std::string data(size, '\xff');
+    if (Checksum(data) != ReferenceChecksum(data)) {
+      Fail("Checksum", data, 0, Checksum(data), ReferenceChecksum(data));
+    }
+  }
+
+  for (int iteration = 0; iteration < 500; iteration++) {
+    std::string data = (iteration % 2) ? Dense(sRandom() % 300)
+                                       : Filler(sRandom() % 300);
+    size_t start = sRandom() % 16;
+    CheckAll(std::string_view(data).substr(std::min(start, data.size())));
+  }
+}
+
+template <typename Function> double Measure(size_t bytes, Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return bytes / elapsed.count() / (1 << 20);
+}
+
+void Benchmark() {
+  static size_t const kSize = 1 << 20;
+  static int const kIterations = 256;
+
+  std::string data = Filler(kSize);
+  size_t total = kSize * kIterations;
+  volatile size_t sink = 0;
+
+  printf("%-28s %10s %10s\n", "", "MiB/s", "reference");
+
+  printf(
+      "%-28s %10.0f %10.0f\n", "Checksum",
+      Measure(total,
+              [&] {
+                for (int n = 0; n < kIterations; n++)
+                  sink = sink + Checksum(data);
+              }),
+      Measure(total, [&] {
+        for (int n = 0; n < kIterations; n++)
+          sink = sink + ReferenceChecksum(data);
+      }));
+
+  for (bool runs : {false, true}) {
+    printf(
+        "%-28s %10.0f %10.0f\n",
+        runs ? "FindEscapableOrRun(runs)" : "FindEscapableOrRun",
+        Measure(total,
+                [&] {
+                  for (int n = 0; n < kIterations; n++)
+                    sink = sink + FindEscapableOrRun(data, 0, runs);
+                }),
+        Measure(total, [&] {
+          for (int n = 0; n < kIterations; n++)
+            sink = sink + ReferenceFind(data, 0, runs);
+        }));
+  }
+
+  // Binary data with an escapable byte every 64 bytes or so.
+  std::string binary = data;
+  for (size_t n = 0; n < binary.size(); n += 48 + sRandom() % 32) {
+    binary[n] = '#';
+  }
+  printf("%-28s %10.0f %10.0f\n", "Escape",
+         Measure(total,
+                 [&] {
+                   for (int n = 0; n < kIterations; n++)
+                     sink = sink + Escape(binary).size();
+                 }),
+         Measure(total, [&] {
+           for (int n = 0; n < kIterations; n++)
+             sink = sink + ReferenceEscape(binary).size();
+         }));
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  bool checkOnly = argc > 1 && strcmp(argv[1], "--check") == 0;
+
+  Check();
+  if (sFailures != 0) {
+    fprintf(stderr, "%u mismatches against the reference implementation\n",
+            sFailures);
+    return EXIT_FAILURE;
+  }
+
+  if (!checkOnly) {
+    Benchmark();
+  }
+  return EXIT_SUCCESS;
+}
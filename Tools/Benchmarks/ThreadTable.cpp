@@ -0,0 +1,251 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Target/ThreadTable.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using ds2::ThreadId;
+using ds2::Target::Thread;
+using ds2::Target::ThreadTable;
+
+// ThreadTable only logs through DS2ASSERT; don't link the host layer for it.
+void ds2::Log(int level, char const *, char const *funcname,
+              char const *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  fprintf(stderr, "%s: ", funcname);
+  vfprintf(stderr, format, ap);
+  fputc('\n', stderr);
+  va_end(ap);
+}
+
+namespace {
+
+std::mt19937 sRandom(0x64733262);
+unsigned sFailures = 0;
+
+// The table never dereferences threads, so any distinct value will do.
+Thread *FakeThread(ThreadId tid) {
+  return reinterpret_cast<Thread *>(static_cast<uintptr_t>(tid) * 16 + 8);
+}
+
+void Fail(char const *what, ThreadId tid) {
+  if (sFailures++ < 20) {
+    fprintf(stderr, "%s: tid=%d\n", what, static_cast<int>(tid));
+  }
+}
+
+void Verify(ThreadTable const &table,
+            std::unordered_map<ThreadId, Thread *> const &reference,
+            std::vector<ThreadId> const &tids) {
+  if (table.size() != reference.size()) {
+    Fail("size mismatch", static_cast<ThreadId>(table.size()));
+  }
+
+  size_t visited = 0;
+  for (auto const &entry : table) {
+    auto it = reference.find(entry.first);
+    if (it == reference.end() || it->second != entry.second) {
+      Fail("iteration returned a stale entry", entry.first);
+    }
+    visited++;
+  }
+  if (visited != reference.size()) {
+    Fail("iteration missed entries", static_cast<ThreadId>(visited));
+  }
+
+  for (ThreadId tid : tids) {
+    auto it = table.find(tid);
+    auto ref = reference.find(tid);
+    if ((it == table.end()) != (ref == reference.end())) {
+      Fail(ref == reference.end() ? "found erased tid" : "lost tid", tid);
+    } else if (it != table.end() &&
+               (it->first != tid || it->second != ref->second)) {
+      Fail("find returned the wrong entry", tid);
+    }
+  }
+}
+
+// Random inserts, erases (by tid and by iterator) and clears, against
+// std::unordered_map. Tids are drawn from a few rows far apart, which share
+// their low bits and so collide in the index; together with a small number
+// of columns this keeps the index crowded, so that probe sequences run into
+// each other and wrap around its end, while the table keeps growing and
+// being cleared again.
+void Check() {
+  static struct {
+    ThreadId rows;
+    ThreadId columns;
+  } const kShapes[] = {{1, 8},  {1, 40}, {16, 4},  {16, 16},
+                       {64, 8}, {8, 64}, {8, 256}, {4, 3000}};
+
+  for (auto const &shape : kShapes) {
+    std::vector<ThreadId> tids;
+    for (ThreadId row = 0; row < shape.rows; row++) {
+      for (ThreadId column = 0; column < shape.columns; column++) {
+        tids.push_back((row << 16) + column);
+      }
+    }
+
+    ThreadTable table;
+    std::unordered_map<ThreadId, Thread *> reference;
+
+    for (int step = 0; step < 20000; step++) {
+      ThreadId tid = tids[sRandom() % tids.size()];
+      unsigned op = sRandom() % 16;
+
+      if (op < 8) {
+        bool inserted = table.insert(tid, FakeThread(tid));
+        bool expected = reference.emplace(tid, FakeThread(tid)).second;
+        if (inserted != expected) {
+          Fail(expected ? "insert refused a new tid" : "insert took a duplicate",
+               tid);
+        }
+      } else if (op < 12) {
+        if (table.erase(tid) != reference.erase(tid)) {
+          Fail("erase by tid", tid);
+        }
+      } else if (op < 15) {
+        auto it = table.find(tid);
+        if (it != table.end()) {
+          table.erase(it);
+          reference.erase(tid);
+        }
+      } else if (sRandom() % 256 == 0) {
+        table.clear();
+        reference.clear();
+      }
+
+      if (tids.size() <= 256 || step % 97 == 0) {
+        Verify(table, reference, tids);
+      }
+    }
+
+    // Drain everything, in random order.
+    std::vector<ThreadId> live;
+    for (auto const &entry : reference) {
+      live.push_back(entry.first);
+    }
+    std::shuffle(live.begin(), live.end(), sRandom);
+    for (ThreadId tid : live) {
+      table.erase(tid);
+      reference.erase(tid);
+      if (tids.size() <= 256) {
+        Verify(table, reference, tids);
+      }
+    }
+    Verify(table, reference, tids);
+  }
+
+  // Sequential tids with a large base, the way the kernel hands them out.
+  ThreadTable table;
+  std::unordered_map<ThreadId, Thread *> reference;
+  for (ThreadId tid = 100000; tid < 110000; tid++) {
+    table.insert(tid, FakeThread(tid));
+    reference.emplace(tid, FakeThread(tid));
+    if (tid % 3 == 0) {
+      table.erase(tid - 7);
+      reference.erase(tid - 7);
+    }
+  }
+  for (auto const &entry : reference) {
+    auto it = table.find(entry.first);
+    if (it == table.end() || it->second != entry.second) {
+      Fail("lost sequential tid", entry.first);
+    }
+  }
+}
+
+template <typename Table> void Insert(Table &table, ThreadId tid) {
+  table.insert(std::make_pair(tid, FakeThread(tid)));
+}
+
+template <> void Insert(ThreadTable &table, ThreadId tid) {
+  table.insert(tid, FakeThread(tid));
+}
+
+// Mirrors how a process with many threads uses its table: every thread is
+// added, looked up and enumerated many times over while it is stopped, then
+// removed as it exits.
+template <typename Table>
+double Measure(std::vector<ThreadId> const &tids, int rounds, int passes) {
+  volatile uintptr_t sink = 0;
+  std::vector<ThreadId> order(tids);
+  std::shuffle(order.begin(), order.end(), sRandom);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    Table table;
+    for (ThreadId tid : tids) {
+      Insert(table, tid);
+    }
+    for (int pass = 0; pass < passes; pass++) {
+      for (ThreadId tid : order) {
+        sink = sink + reinterpret_cast<uintptr_t>(table.find(tid)->second);
+      }
+      for (auto const &entry : table) {
+        sink = sink + entry.first;
+      }
+    }
+    for (ThreadId tid : order) {
+      table.erase(tid);
+    }
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+void Benchmark() {
+  static int const kRounds = 20;
+  static int const kPasses = 50;
+
+  printf("%-8s %12s %12s %12s\n", "threads", "std::map", "unordered",
+         "ThreadTable");
+  for (size_t count : {100u, 1000u, 10000u, 100000u}) {
+    std::vector<ThreadId> tids;
+    for (size_t n = 0; n < count; n++) {
+      tids.push_back(static_cast<ThreadId>(4000 + n * 3 + sRandom() % 3));
+    }
+    int rounds = std::max<int>(1, kRounds * 10000 / count);
+
+    printf("%-8zu %10.1fms %10.1fms %10.1fms\n", count,
+           Measure<std::map<ThreadId, Thread *>>(tids, rounds, kPasses),
+           Measure<std::unordered_map<ThreadId, Thread *>>(tids, rounds,
+                                                           kPasses),
+           Measure<ThreadTable>(tids, rounds, kPasses));
+  }
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  bool checkOnly = argc > 1 && strcmp(argv[1], "--check") == 0;
+
+  Check();
+  if (sFailures != 0) {
+    fprintf(stderr, "%u mismatches against std::unordered_map\n", sFailures);
+    return EXIT_FAILURE;
+  }
+
+  if (!checkOnly) {
+    Benchmark();
+  }
+  return EXIT_SUCCESS;
+}